@@ -1,5 +1,6 @@
 #pragma once
 #include <atomic>
+#include <chrono>
 
 // todo better nameing
 struct Event
@@ -11,7 +12,9 @@ struct Event
 
     void endEvent()
     {
+        _endedAt = std::chrono::steady_clock::now().time_since_epoch().count();
         _done.test_and_set();
+        _done.notify_all();
     }
 
     void restartEvent()
@@ -19,6 +22,18 @@ struct Event
         _done.clear();
     }
 
+    // Sleeps (futex on Linux) until endEvent() is called, returns immediately if it already was.
+    void waitForEvent()
+    {
+        _done.wait(false);
+    }
+
+    // Time from endEvent() until now, used to check wake up latency of waiting thread.
+    std::chrono::nanoseconds sinceEnded() const
+    {
+        return std::chrono::steady_clock::now().time_since_epoch() - std::chrono::steady_clock::duration(_endedAt.load());
+    }
+
     std::atomic_flag _done;
+    std::atomic<std::chrono::steady_clock::rep> _endedAt = 0;
 };
-
@@ -0,0 +1,285 @@
+#include "aggTradeDecoder.h"
+
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Bits of fields that every aggTrade must carry.
+    enum Field : uint32_t
+    {
+        EventType    = 1 << 0,
+        EventTime    = 1 << 1,
+        Symbol       = 1 << 2,
+        AggTradeId   = 1 << 3,
+        Price        = 1 << 4,
+        Quantity     = 1 << 5,
+        FirstTradeId = 1 << 6,
+        LastTradeId  = 1 << 7,
+        TradeTime    = 1 << 8,
+        BuyerMaker   = 1 << 9,
+        All          = (1 << 10) - 1
+    };
+
+    // Position of the first '"' or '\\' in [p, end), or end.
+    const char* findQuoteOrEscape(const char* p, const char* end)
+    {
+#if defined(__SSE2__)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i escape = _mm_set1_epi8('\\');
+        for (; p + 16 <= end; p += 16)
+        {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, escape)));
+            if (mask != 0)
+                return p + __builtin_ctz(mask);
+        }
+#endif
+        for (; p < end; ++p)
+        {
+            if (*p == '"' || *p == '\\')
+                return p;
+        }
+        return end;
+    }
+
+    struct Cursor
+    {
+        const char* p;
+        const char* end;
+
+        void skipWhitespace()
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+                ++p;
+        }
+
+        bool consume(char c)
+        {
+            skipWhitespace();
+            if (p == end || *p != c)
+                return false;
+            ++p;
+            return true;
+        }
+
+        // Expects p right after the opening quote, leaves p after the closing one.
+        bool readString(std::string_view& out)
+        {
+            const char* begin = p;
+            for (;;)
+            {
+                p = findQuoteOrEscape(p, end);
+                if (p == end)
+                    return false;
+                if (*p == '"')
+                    break;
+                // Escaped character, aggTrade fields never contain them but skip it correctly anyway.
+                p += 2;
+                if (p > end)
+                    return false;
+            }
+            out = std::string_view(begin, p - begin);
+            ++p;
+            return true;
+        }
+
+        bool readUnsigned(uint64_t& out)
+        {
+            const auto [ptr, ec] = std::from_chars(p, end, out);
+            if (ec != std::errc{})
+                return false;
+            p = ptr;
+            return true;
+        }
+
+        // Prices and quantities are sent as strings: "0.00123000"
+        bool readQuotedDouble(double& out)
+        {
+            std::string_view text;
+            if (!consume('"') || !readString(text) || text.empty())
+                return false;
+            const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+            return ec == std::errc{} && ptr == text.data() + text.size();
+        }
+
+        bool readBool(bool& out)
+        {
+            if (end - p >= 4 && std::memcmp(p, "true", 4) == 0)
+            {
+                out = true;
+                p += 4;
+                return true;
+            }
+            if (end - p >= 5 && std::memcmp(p, "false", 5) == 0)
+            {
+                out = false;
+                p += 5;
+                return true;
+            }
+            return false;
+        }
+
+        // Skips a value of unknown field (numbers, literals, strings, nested objects and arrays).
+        bool skipValue()
+        {
+            skipWhitespace();
+            int depth = 0;
+            std::string_view ignored;
+            while (p < end)
+            {
+                const char c = *p;
+                if (c == '"')
+                {
+                    ++p;
+                    if (!readString(ignored))
+                        return false;
+                    if (depth == 0)
+                        return true;
+                    continue;
+                }
+                if (c == '{' || c == '[')
+                {
+                    ++depth;
+                }
+                else if (c == '}' || c == ']')
+                {
+                    if (depth == 0)
+                        return true;
+                    if (--depth == 0)
+                    {
+                        ++p;
+                        return true;
+                    }
+                }
+                else if (c == ',' && depth == 0)
+                {
+                    return true;
+                }
+                ++p;
+            }
+            return false;
+        }
+    };
+}
+
+bool AggTradeDecoder::decode(std::string_view json, AggTrade& trade)
+{
+    Cursor cursor{ json.data(), json.data() + json.size() };
+    uint32_t seen = 0;
+
+    if (!cursor.consume('{'))
+        return false;
+
+    for (;;)
+    {
+        std::string_view key;
+        if (!cursor.consume('"') || !cursor.readString(key) || !cursor.consume(':'))
+            return false;
+        cursor.skipWhitespace();
+
+        bool ok = true;
+        if (key.size() != 1)
+        {
+            ok = cursor.skipValue();
+        }
+        else
+        {
+            switch (key[0])
+            {
+            case 'e':
+            {
+                std::string_view type;
+                ok = cursor.consume('"') && cursor.readString(type) && type == "aggTrade";
+                seen |= EventType;
+                break;
+            }
+            case 'E':
+                ok = cursor.readUnsigned(trade.eventTime);
+                seen |= EventTime;
+                break;
+            case 's':
+            {
+                std::string_view symbol;
+                ok = cursor.consume('"') && cursor.readString(symbol) && !symbol.empty() && symbol.size() <= AggTrade::c_maxSymbolLength;
+                if (ok)
+                {
+                    std::memcpy(trade.symbol, symbol.data(), symbol.size());
+                    trade.symbolLength = static_cast<uint8_t>(symbol.size());
+                }
+                seen |= Symbol;
+                break;
+            }
+            case 'a':
+                ok = cursor.readUnsigned(trade.aggTradeId);
+                seen |= AggTradeId;
+                break;
+            case 'p':
+                ok = cursor.readQuotedDouble(trade.price);
+                seen |= Price;
+                break;
+            case 'q':
+                ok = cursor.readQuotedDouble(trade.quantity);
+                seen |= Quantity;
+                break;
+            case 'f':
+                ok = cursor.readUnsigned(trade.firstTradeId);
+                seen |= FirstTradeId;
+                break;
+            case 'l':
+                ok = cursor.readUnsigned(trade.lastTradeId);
+                seen |= LastTradeId;
+                break;
+            case 'T':
+                ok = cursor.readUnsigned(trade.tradeTime);
+                seen |= TradeTime;
+                break;
+            case 'm':
+                ok = cursor.readBool(trade.isBuyerMaker);
+                seen |= BuyerMaker;
+                break;
+            default: // "M" (ignore) and anything exchange adds later
+                ok = cursor.skipValue();
+                break;
+            }
+        }
+
+        if (!ok)
+            return false;
+
+        if (cursor.consume(','))
+            continue;
+        if (cursor.consume('}'))
+            break;
+        return false;
+    }
+
+    return seen == All;
+}
+
+bool AggTradeDecoder::splitCombinedFrame(std::string_view frame, std::string_view& symbol, std::string_view& data)
+{
+    constexpr std::string_view streamKey = "{\"stream\":\"";
+    constexpr std::string_view dataKey = ",\"data\":";
+    if (frame.substr(0, streamKey.size()) != streamKey)
+        return false;
+
+    const char* streamBegin = frame.data() + streamKey.size();
+    const char* frameEnd = frame.data() + frame.size();
+    const char* streamEnd = findQuoteOrEscape(streamBegin, frameEnd);
+    if (streamEnd == frameEnd || *streamEnd != '"')
+        return false;
+
+    std::string_view stream(streamBegin, streamEnd - streamBegin);
+    std::string_view rest(streamEnd + 1, frameEnd - streamEnd - 1);
+    if (rest.substr(0, dataKey.size()) != dataKey || rest.size() <= dataKey.size() || rest.back() != '}')
+        return false;
+
+    symbol = stream.substr(0, stream.find('@'));
+    data = rest.substr(dataKey.size(), rest.size() - dataKey.size() - 1);
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Decoded aggregate trade, see https://developers.binance.com/docs/binance-spot-api-docs/web-socket-streams#aggregate-trade-streams
+struct AggTrade
+{
+    static constexpr size_t c_maxSymbolLength = 23;
+
+    std::string_view getSymbol() const { return { symbol, symbolLength }; }
+
+    uint64_t eventTime = 0;    // "E"
+    uint64_t aggTradeId = 0;   // "a"
+    uint64_t firstTradeId = 0; // "f"
+    uint64_t lastTradeId = 0;  // "l"
+    uint64_t tradeTime = 0;    // "T"
+    double price = 0.0;        // "p"
+    double quantity = 0.0;     // "q"
+    char symbol[c_maxSymbolLength] = {}; // "s"
+    uint8_t symbolLength = 0;
+    bool isBuyerMaker = false; // "m"
+};
+
+// Single pass decoder for the fixed aggTrade schema, replaces building a nlohmann::json DOM per message.
+// String scanning uses SSE2 when available and falls back to scalar code otherwise.
+// Never throws and never allocates: malformed input, wrong event type or missing fields make decode() return false.
+class AggTradeDecoder
+{
+public:
+    static bool decode(std::string_view json, AggTrade& trade);
+
+    // Splits combined stream envelope {"stream":"<symbol>@aggTrade","data":{...}} without copying.
+    static bool splitCombinedFrame(std::string_view frame, std::string_view& symbol, std::string_view& data);
+};
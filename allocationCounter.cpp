@@ -0,0 +1,93 @@
+#include "allocationCounter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+namespace
+{
+    thread_local uint64_t t_allocations = 0;
+    thread_local int64_t t_liveBytes = 0;
+    thread_local int64_t t_peakBytes = 0;
+}
+
+#ifdef SCRAPPER_COUNT_ALLOCATIONS
+
+namespace
+{
+    void* countedAllocate(std::size_t size) noexcept
+    {
+        ++t_allocations;
+        void* ptr = std::malloc(size ? size : 1);
+        if (ptr)
+        {
+            t_liveBytes += malloc_usable_size(ptr);
+            t_peakBytes = std::max(t_peakBytes, t_liveBytes);
+        }
+        return ptr;
+    }
+
+    void countedFree(void* ptr) noexcept
+    {
+        if (ptr)
+            t_liveBytes -= malloc_usable_size(ptr);
+        std::free(ptr);
+    }
+}
+
+bool AllocationCounter::enabled() { return true; }
+
+void* operator new(std::size_t size)
+{
+    if (void* ptr = countedAllocate(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { countedFree(ptr); }
+
+#else
+
+bool AllocationCounter::enabled() { return false; }
+
+#endif
+
+uint64_t AllocationCounter::threadAllocations()
+{
+    return t_allocations;
+}
+
+int64_t AllocationCounter::threadLiveBytes()
+{
+    return t_liveBytes;
+}
+
+int64_t AllocationCounter::threadPeakBytes()
+{
+    return t_peakBytes;
+}
+
+void AllocationCounter::resetThreadPeakBytes()
+{
+    t_peakBytes = t_liveBytes;
+}
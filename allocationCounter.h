@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-thread heap allocation counter. Global operator new is replaced in allocationCounter.cpp
+// when built with SCRAPPER_COUNT_ALLOCATIONS, otherwise counters always read zero.
+namespace AllocationCounter
+{
+    bool enabled();
+
+    // Number of operator new calls made by the calling thread so far.
+    uint64_t threadAllocations();
+
+    // Bytes allocated minus bytes freed by the calling thread, and the highest value it reached since resetThreadPeakBytes().
+    // Meant for measuring peak memory of a piece of work done on one thread (e.g. a parse).
+    int64_t threadLiveBytes();
+
+    int64_t threadPeakBytes();
+
+    void resetThreadPeakBytes();
+}
+
+// Tracks allocations done while handling each message of one stream, to prove the hot path is allocation free.
+// First c_warmUpMessages are ignored: buffers and per-symbol state grow to steady state size there.
+struct AllocationsPerMessage
+{
+    static constexpr uint64_t c_warmUpMessages = 1024;
+
+    void record(uint64_t allocations)
+    {
+        if (++messages <= c_warmUpMessages)
+            return;
+        steadyStateAllocations += allocations;
+    }
+
+    uint64_t steadyStateMessages() const { return messages > c_warmUpMessages ? messages - c_warmUpMessages : 0; }
+
+    uint64_t messages = 0;
+    uint64_t steadyStateAllocations = 0;
+};
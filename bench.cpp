@@ -0,0 +1,569 @@
+// scrapper_bench: micro benchmarks of the per message path and of the periodic update path.
+// Results are machine readable with --benchmark_format=json or --benchmark_out=<file> --benchmark_out_format=json.
+
+#include <benchmark/benchmark.h>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "aggTradeDecoder.h"
+#include "allocationCounter.h"
+#include "latencyHistogram.h"
+#include "mpscQueue.h"
+#include "parser.h"
+#include "service.h"
+#include "spscRing.h"
+#include "symbolTable.h"
+#include "tlsSessionCache.h"
+#include "tradingSystem.h"
+#include "webSocketConnection.h"
+
+namespace
+{
+    std::string aggTradeData(uint64_t id, double price)
+    {
+        char buffer[512];
+        const int size = std::snprintf(buffer, sizeof(buffer),
+            R"({"e":"aggTrade","E":1672515782136,"s":"BTCUSDT","a":%llu,"p":"%.8f","q":"0.00150000","f":100,"l":105,"T":1672515782136,"m":true,"M":true})",
+            static_cast<unsigned long long>(id), price);
+        return std::string(buffer, size);
+    }
+
+    std::string combinedFrame(uint64_t id, double price)
+    {
+        return R"({"stream":"btcusdt@aggTrade","data":)" + aggTradeData(id, price) + "}";
+    }
+
+    // Prices walk up and down, so moving averages cross and the strategy trades now and then.
+    std::vector<std::string> aggTradePayloads(size_t count, bool combined)
+    {
+        std::vector<std::string> payloads;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double price = 16500.0 + 50.0 * ((i / 40) % 2 == 0 ? (i % 40) : 40.0 - (i % 40));
+            payloads.push_back(combined ? combinedFrame(i, price) : aggTradeData(i, price));
+        }
+        return payloads;
+    }
+
+    std::string symbolName(size_t i)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "sym%05zuusdt", i);
+        return buffer;
+    }
+
+    // Shaped like the real /api/v3/exchangeInfo: each symbol has filters and permissions, about 1.5 KB per symbol.
+    std::string writeExchangeInfo(size_t symbols)
+    {
+        nlohmann::json info;
+        info["timezone"] = "UTC";
+        info["serverTime"] = 1672515782136;
+        info["rateLimits"] = nlohmann::json::array({ { { "rateLimitType", "REQUEST_WEIGHT" }, { "interval", "MINUTE" }, { "intervalNum", 1 }, { "limit", 6000 } } });
+        info["symbols"] = nlohmann::json::array();
+        for (size_t i = 0; i < symbols; ++i)
+        {
+            nlohmann::json symbol;
+            symbol["symbol"] = symbolName(i);
+            symbol["status"] = "TRADING";
+            symbol["baseAsset"] = "SYM";
+            symbol["baseAssetPrecision"] = 8;
+            symbol["quoteAsset"] = "USDT";
+            symbol["quotePrecision"] = 8;
+            symbol["orderTypes"] = { "LIMIT", "LIMIT_MAKER", "MARKET", "STOP_LOSS_LIMIT", "TAKE_PROFIT_LIMIT" };
+            symbol["icebergAllowed"] = true;
+            symbol["ocoAllowed"] = true;
+            symbol["isSpotTradingAllowed"] = true;
+            symbol["isMarginTradingAllowed"] = false;
+            symbol["filters"] = nlohmann::json::array({
+                { { "filterType", "PRICE_FILTER" }, { "minPrice", "0.01000000" }, { "maxPrice", "1000000.00000000" }, { "tickSize", "0.01000000" } },
+                { { "filterType", "LOT_SIZE" }, { "minQty", "0.00001000" }, { "maxQty", "9000.00000000" }, { "stepSize", "0.00001000" } },
+                { { "filterType", "ICEBERG_PARTS" }, { "limit", 10 } },
+                { { "filterType", "MARKET_LOT_SIZE" }, { "minQty", "0.00000000" }, { "maxQty", "110.00000000" }, { "stepSize", "0.00000000" } },
+                { { "filterType", "TRAILING_DELTA" }, { "minTrailingAboveDelta", 10 }, { "maxTrailingAboveDelta", 2000 } },
+                { { "filterType", "PERCENT_PRICE_BY_SIDE" }, { "bidMultiplierUp", "5" }, { "bidMultiplierDown", "0.2" }, { "askMultiplierUp", "5" }, { "askMultiplierDown", "0.2" } },
+                { { "filterType", "NOTIONAL" }, { "minNotional", "5.00000000" }, { "maxNotional", "9000000.00000000" } },
+                { { "filterType", "MAX_NUM_ORDERS" }, { "maxNumOrders", 200 } } });
+            symbol["permissions"] = { "SPOT", "MARGIN", "TRD_GRP_004", "TRD_GRP_005", "TRD_GRP_006" };
+            info["symbols"].push_back(std::move(symbol));
+        }
+
+        const auto path = (std::filesystem::temp_directory_path() / ("scrapper_bench_exchange_info_" + std::to_string(symbols) + ".json")).string();
+        std::ofstream(path) << info.dump();
+        return path;
+    }
+}
+
+// aggTrade decoding: the decoder used on the message path against building a nlohmann::json DOM (what it replaced).
+static void BM_AggTradeDecoder(benchmark::State& state)
+{
+    const auto payloads = aggTradePayloads(1024, false);
+    size_t i = 0;
+    AggTrade trade;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(AggTradeDecoder::decode(payloads[i++ & 1023], trade));
+        benchmark::DoNotOptimize(trade);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AggTradeDecoder);
+
+static void BM_AggTradeNlohmann(benchmark::State& state)
+{
+    const auto payloads = aggTradePayloads(1024, false);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const auto json = nlohmann::json::parse(payloads[i++ & 1023]);
+        double price = std::stod(json["p"].get<std::string>());
+        double quantity = std::stod(json["q"].get<std::string>());
+        std::string symbol = json["s"];
+        benchmark::DoNotOptimize(price);
+        benchmark::DoNotOptimize(quantity);
+        benchmark::DoNotOptimize(symbol);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AggTradeNlohmann);
+
+// Strategy on realistic aggTrade payloads: from raw JSON and from an already decoded trade.
+static void BM_TradingAlgorithmExecuteJson(benchmark::State& state)
+{
+    const auto payloads = aggTradePayloads(1024, false);
+    TradingAlgorithm algorithm;
+    size_t i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(algorithm.execute(std::string_view(payloads[i++ & 1023])));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TradingAlgorithmExecuteJson);
+
+static void BM_TradingAlgorithmExecuteTrade(benchmark::State& state)
+{
+    const auto payloads = aggTradePayloads(1024, false);
+    std::vector<AggTrade> trades(payloads.size());
+    for (size_t i = 0; i < payloads.size(); ++i)
+        AggTradeDecoder::decode(payloads[i], trades[i]);
+
+    TradingAlgorithm algorithm;
+    size_t i = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(algorithm.execute(trades[i++ & 1023]));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TradingAlgorithmExecuteTrade);
+
+// Cost per trade against long window length (short window is a quarter of it), should stay flat: running sums over a ring, no re-summing.
+static void BM_TradingAlgorithmWindow(benchmark::State& state)
+{
+    const auto payloads = aggTradePayloads(1024, false);
+    std::vector<AggTrade> trades(payloads.size());
+    for (size_t i = 0; i < payloads.size(); ++i)
+        AggTradeDecoder::decode(payloads[i], trades[i]);
+
+    const size_t longWindow = static_cast<size_t>(state.range(0));
+    TradingAlgorithm algorithm(longWindow / 4, longWindow);
+    size_t i = 0;
+    for (size_t filled = 0; filled < longWindow; ++filled)
+        algorithm.execute(trades[i++ & 1023]);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(algorithm.execute(trades[i++ & 1023]));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TradingAlgorithmWindow)->Arg(20)->Arg(1000)->Arg(100000);
+
+// readMessage frame handling: copying the frame out of the read buffer (previous code) against a view into it.
+static void BM_ReadMessageCopy(benchmark::State& state)
+{
+    const auto frames = aggTradePayloads(1024, true);
+    boost::beast::flat_buffer buffer;
+    buffer.reserve(64 * 1024);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const std::string& frame = frames[i++ & 1023];
+        buffer.commit(boost::asio::buffer_copy(buffer.prepare(frame.size()), boost::asio::buffer(frame)));
+
+        const char* data = static_cast<const char*>(buffer.data().data());
+        std::string copy(data, buffer.size());
+        std::string_view symbol;
+        std::string_view payload;
+        benchmark::DoNotOptimize(AggTradeDecoder::splitCombinedFrame(copy, symbol, payload));
+        buffer.consume(buffer.size());
+    }
+    state.SetBytesProcessed(state.iterations() * frames.front().size());
+}
+BENCHMARK(BM_ReadMessageCopy);
+
+static void BM_ReadMessageView(benchmark::State& state)
+{
+    const auto frames = aggTradePayloads(1024, true);
+    boost::beast::flat_buffer buffer;
+    buffer.reserve(64 * 1024);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const std::string& frame = frames[i++ & 1023];
+        buffer.commit(boost::asio::buffer_copy(buffer.prepare(frame.size()), boost::asio::buffer(frame)));
+
+        const std::string_view view(static_cast<const char*>(buffer.data().data()), buffer.size());
+        std::string_view symbol;
+        std::string_view payload;
+        benchmark::DoNotOptimize(AggTradeDecoder::splitCombinedFrame(view, symbol, payload));
+        buffer.consume(buffer.size());
+    }
+    state.SetBytesProcessed(state.iterations() * frames.front().size());
+}
+BENCHMARK(BM_ReadMessageView);
+
+// Per message path of WebSocketClient without the socket: frame in the read buffer, stream lookup, decode, latency, strategy.
+// Guards the "no heap allocation per message" goal: after warm-up (AllocationsPerMessage, same as connections use)
+// any operator new on this thread fails the run.
+static void BM_MessagePathAllocations(benchmark::State& state)
+{
+    const auto frames = aggTradePayloads(1024, true);
+    boost::beast::flat_buffer buffer;
+    buffer.reserve(64 * 1024);
+    std::unordered_map<std::string, SymbolStream, StringHash, std::equal_to<>> streams;
+    SymbolStream& btc = streams["btcusdt"];
+    btc.latency = std::make_shared<SymbolLatency>("btcusdt", 0, nullptr);
+    AllocationsPerMessage allocations;
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const uint64_t allocationsBefore = AllocationCounter::threadAllocations();
+        const std::string& frame = frames[i++ & 1023];
+        buffer.commit(boost::asio::buffer_copy(buffer.prepare(frame.size()), boost::asio::buffer(frame)));
+
+        const int64_t receivedNs = systemNowNs();
+        std::string_view symbol;
+        std::string_view data;
+        AggTrade trade;
+        const std::string_view view(static_cast<const char*>(buffer.data().data()), buffer.size());
+        if (AggTradeDecoder::splitCombinedFrame(view, symbol, data) && AggTradeDecoder::decode(data, trade))
+        {
+            if (auto it = streams.find(symbol); it != streams.end())
+            {
+                it->second.latency->recordReceive(trade.eventTime, receivedNs);
+                benchmark::DoNotOptimize(it->second.algorithm->execute(trade));
+                it->second.latency->recordDone(receivedNs, systemNowNs());
+            }
+        }
+        buffer.consume(buffer.size());
+        allocations.record(AllocationCounter::threadAllocations() - allocationsBefore);
+    }
+
+    state.counters["allocs_per_msg"] = allocations.steadyStateMessages() ? static_cast<double>(allocations.steadyStateAllocations) / allocations.steadyStateMessages() : 0.0;
+    if (!AllocationCounter::enabled())
+        state.SkipWithError("built without SCRAPPER_COUNT_ALLOCATIONS, allocations are not counted");
+    else if (allocations.steadyStateAllocations != 0)
+        state.SkipWithError(fmt::format("{} heap allocations in {} messages after warm-up", allocations.steadyStateAllocations, allocations.steadyStateMessages()).c_str());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MessagePathAllocations);
+
+// exchangeInfo parsing, Arg is number of symbols (3500 is about the size of the real one).
+// peak_heap_bytes is the highest heap usage of one parse (needs SCRAPPER_COUNT_ALLOCATIONS, zero otherwise).
+template<typename Parse>
+static void parseExchangeInfoBenchmark(benchmark::State& state, Parse parse)
+{
+    const std::string path = writeExchangeInfo(state.range(0));
+    int64_t peakBytes = 0;
+    for (auto _ : state)
+    {
+        const int64_t liveBefore = AllocationCounter::threadLiveBytes();
+        AllocationCounter::resetThreadPeakBytes();
+        benchmark::DoNotOptimize(parse(path));
+        peakBytes = std::max(peakBytes, AllocationCounter::threadPeakBytes() - liveBefore);
+    }
+    state.SetBytesProcessed(state.iterations() * std::filesystem::file_size(path));
+    state.counters["peak_heap_bytes"] = static_cast<double>(peakBytes);
+    std::filesystem::remove(path);
+}
+
+// Streaming SAX parse used by the service.
+static void BM_ParseSecurities(benchmark::State& state)
+{
+    parseExchangeInfoBenchmark(state, [](const std::string& path) { return Parser::parseSecurities(path); });
+}
+BENCHMARK(BM_ParseSecurities)->Arg(3500)->Unit(benchmark::kMillisecond);
+
+// Previous approach: whole document into a nlohmann::json DOM, then symbols[].symbol lowercased char by char.
+static void BM_ParseSecuritiesDom(benchmark::State& state)
+{
+    parseExchangeInfoBenchmark(state, [](const std::string& path)
+    {
+        std::vector<std::string> symbols;
+        std::ifstream file(path);
+        nlohmann::json data;
+        file >> data;
+        for (const auto& symbolData : data["symbols"])
+        {
+            auto symbol = symbolData["symbol"].get<std::string>();
+            std::for_each(symbol.begin(), symbol.end(), [](char& c){ c = std::tolower(c); });
+            symbols.push_back(std::move(symbol));
+        }
+        return symbols;
+    });
+}
+BENCHMARK(BM_ParseSecuritiesDom)->Arg(3500)->Unit(benchmark::kMillisecond);
+
+// Args: symbols on exchange, symbols in config (0 - take all matching the filter).
+static void BM_FindIntersection(benchmark::State& state)
+{
+    std::vector<SymbolId> symbols;
+    for (size_t i = 0; i < static_cast<size_t>(state.range(0)); ++i)
+        symbols.push_back(SymbolTable::instance().intern(symbolName(i)));
+    std::vector<std::string> configured;
+    for (size_t i = 0; i < static_cast<size_t>(state.range(1)); ++i)
+        configured.push_back(symbolName(state.range(0) - 1 - i * 13 % state.range(0))); // 13 is coprime with 3500, all names differ
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Service::findIntersection(symbols, configured, "usdt"));
+}
+BENCHMARK(BM_FindIntersection)->Args({ 3500, 0 })->Args({ 3500, 3000 })->Unit(benchmark::kMicrosecond);
+
+// Symbol set reconciliation between two refreshes, Arg is number of symbols, a few percent of them change.
+static void BM_ReconcileSymbols(benchmark::State& state)
+{
+    const size_t count = state.range(0);
+    std::vector<SymbolId> previous;
+    std::vector<SymbolId> current;
+    for (size_t i = 0; i < count + count / 32; ++i)
+    {
+        const SymbolId id = SymbolTable::instance().intern(symbolName(i));
+        if (i < count)
+            previous.push_back(id);
+        if (i >= count / 32)
+            current.push_back(id);
+    }
+
+    const SymbolSet previousSet(previous);
+    SymbolSet currentSet;
+    for (auto _ : state)
+    {
+        currentSet.assign(current);
+        benchmark::DoNotOptimize(SymbolSet::diff(previousSet, currentSet));
+    }
+}
+BENCHMARK(BM_ReconcileSymbols)->Arg(3500)->Unit(benchmark::kMicrosecond);
+
+// Failure reports from many io threads: mutex guarded set (previous FailedConnectionsContainer) against the MPSC queue.
+// Thread 0 also plays the manager and drains.
+namespace
+{
+    struct MutexFailedSymbols
+    {
+        std::mutex mutex;
+        std::unordered_set<std::string> symbols;
+    };
+
+    MutexFailedSymbols g_mutexFailed;
+    FailedConnectionsQueue g_queueFailed;
+}
+
+static void BM_FailedConnectionsMutexSet(benchmark::State& state)
+{
+    const std::string symbol = symbolName(state.thread_index());
+    std::unordered_set<std::string> drained;
+    for (auto _ : state)
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_mutexFailed.mutex);
+            g_mutexFailed.symbols.insert(symbol);
+        }
+        if (state.thread_index() == 0)
+        {
+            std::lock_guard<std::mutex> lock(g_mutexFailed.mutex);
+            drained.swap(g_mutexFailed.symbols);
+            g_mutexFailed.symbols.clear();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FailedConnectionsMutexSet)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_FailedConnectionsMpscQueue(benchmark::State& state)
+{
+    const SymbolId symbol = SymbolTable::instance().intern(symbolName(state.thread_index()));
+    const boost::beast::error_code ec;
+    SymbolSet drained;
+    for (auto _ : state)
+    {
+        g_queueFailed.add(symbol, ec);
+        if (state.thread_index() == 0)
+            g_queueFailed.drain([&drained](const FailureRecord& record) { drained.insert(record.symbolId); });
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FailedConnectionsMpscQueue)->ThreadRange(1, 8)->UseRealTime();
+
+// Correctness under contention, not only speed: Arg producers push numbered records while this thread drains,
+// every record has to arrive exactly once and in order per producer. A violation fails the benchmark.
+static void BM_MpscQueueStress(benchmark::State& state)
+{
+    struct Record
+    {
+        uint32_t producer;
+        uint32_t sequence;
+    };
+    constexpr uint32_t c_perProducer = 200000;
+    const size_t producers = state.range(0);
+    const size_t expected = producers * c_perProducer;
+    auto queue = std::make_unique<MpscQueue<Record, 1 << 12>>();
+
+    for (auto _ : state)
+    {
+        std::vector<uint32_t> next(producers, 0);
+        bool ordered = true;
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&queue, p]()
+            {
+                for (uint32_t i = 0; i < c_perProducer; ++i)
+                {
+                    while (!queue->tryPush({ static_cast<uint32_t>(p), i }))
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        auto check = [&next, &ordered, producers](const Record& record)
+        {
+            ordered &= record.producer < producers && record.sequence == next[record.producer]++;
+        };
+        size_t received = 0;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (received < expected && std::chrono::steady_clock::now() < deadline)
+            received += queue->drain(check);
+        for (auto& thread : threads)
+            thread.join();
+        received += queue->drain(check);
+
+        if (!ordered || received != expected)
+        {
+            state.SkipWithError(fmt::format("{} of {} records received, per producer order {}", received, expected, ordered ? "kept" : "broken").c_str());
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * expected);
+}
+BENCHMARK(BM_MpscQueueStress)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Handoff between io thread and strategy worker, one push and one pop per iteration on the same thread.
+static void BM_SpscRingPushPop(benchmark::State& state)
+{
+    SpscRing<AggTrade> ring(4096);
+    AggTrade trade;
+    uint64_t position = 0;
+    for (auto _ : state)
+    {
+        ring.tryPush(trade);
+        benchmark::DoNotOptimize(ring.tryPop(trade, position));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpscRingPushPop);
+
+static void BM_LatencyHistogramRecord(benchmark::State& state)
+{
+    LatencyHistogram histogram;
+    int64_t value = 1;
+    for (auto _ : state)
+    {
+        histogram.record(value);
+        value = (value * 7 + 13) & 0xFFFFF;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LatencyHistogramRecord);
+
+// Reconnect cost with and without TlsSessionCache: TCP connect + TLS handshake per iteration against a local
+// scrapper_mock_exchange given as SCRAPPER_BENCH_TLS=host:port (skipped when not set). Arg 1 offers the session
+// of the previous connection, Arg 0 always does a full handshake. Certificate is not verified (self-signed mock),
+// a full handshake against Binance also pays for chain verification.
+static void BM_TlsHandshake(benchmark::State& state)
+{
+    namespace net = boost::asio;
+    namespace ssl = net::ssl;
+
+    const char* endpoint = std::getenv("SCRAPPER_BENCH_TLS");
+    const std::string_view target = endpoint ? endpoint : "";
+    const size_t colon = target.rfind(':');
+    if (colon == std::string_view::npos)
+    {
+        state.SkipWithError("set SCRAPPER_BENCH_TLS=host:port of a running scrapper_mock_exchange");
+        return;
+    }
+    const std::string host(target.substr(0, colon));
+    const std::string port(target.substr(colon + 1));
+    const bool resume = state.range(0) != 0;
+
+    net::io_context ioc;
+    ssl::context ctx(ssl::context::tlsv12_client);
+    ctx.set_verify_mode(ssl::verify_none);
+    if (resume)
+        TlsSessionCache::instance().attach(ctx);
+
+    boost::system::error_code ec;
+    const auto endpoints = net::ip::tcp::resolver(ioc).resolve(host, port, ec);
+    if (ec)
+    {
+        state.SkipWithError(fmt::format("resolve {}: {}", target, ec.message()).c_str());
+        return;
+    }
+
+    const uint64_t resumedBefore = TlsSessionCache::instance().resumedHandshakes();
+    for (auto _ : state)
+    {
+        ssl::stream<net::ip::tcp::socket> stream(ioc, ctx);
+        if (resume)
+            TlsSessionCache::instance().prepare(stream.native_handle(), host, port);
+        net::connect(stream.next_layer(), endpoints, ec);
+        if (!ec)
+            stream.handshake(ssl::stream_base::client, ec);
+        if (ec)
+        {
+            state.SkipWithError(fmt::format("handshake with {}: {}", target, ec.message()).c_str());
+            break;
+        }
+        TlsSessionCache::instance().onHandshake(stream.native_handle());
+        // Closed without waiting for close_notify of the mock, but marked as shut down so OpenSSL keeps the session resumable.
+        SSL_set_shutdown(stream.native_handle(), SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        stream.next_layer().close(ec);
+    }
+    state.counters["resumed"] = benchmark::Counter(static_cast<double>(TlsSessionCache::instance().resumedHandshakes() - resumedBefore), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TlsHandshake)->ArgName("resume")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char** argv)
+{
+    // Strategy logs every trade, that is not what is measured here.
+    spdlog::set_level(spdlog::level::warn);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
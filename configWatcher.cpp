@@ -0,0 +1,78 @@
+#include "configWatcher.h"
+
+#include <spdlog/spdlog.h>
+
+#include <sys/inotify.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+ConfigWatcher::ConfigWatcher(const std::string& path, std::function<void()> onChange)
+    : _descriptor(_ioc)
+    , _debounce(_ioc)
+    , _onChange(std::move(onChange))
+{
+    const std::filesystem::path file(path);
+    _fileName = file.filename().string();
+    const std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+
+    const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "inotify_init1");
+    _descriptor.assign(fd);
+    if (inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        throw std::system_error(errno, std::generic_category(), "inotify_add_watch " + directory);
+
+    spdlog::info("Watching {} for changes", path);
+    read();
+    _thread = std::thread([this]() { _ioc.run(); });
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    _ioc.stop();
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void ConfigWatcher::read()
+{
+    _descriptor.async_read_some(net::buffer(_buffer), [this](const boost::system::error_code& ec, size_t bytes)
+    {
+        if (ec == net::error::operation_aborted)
+            return;
+        if (ec)
+        {
+            spdlog::error("Config watcher read: {}, config is not reloaded any more", ec.message());
+            return;
+        }
+
+        if (touchesFile(bytes) && !_pending)
+        {
+            _pending = true;
+            _debounce.expires_after(c_debounce);
+            _debounce.async_wait([this](const boost::system::error_code& ec)
+            {
+                _pending = false;
+                if (!ec)
+                    _onChange();
+            });
+        }
+        read();
+    });
+}
+
+bool ConfigWatcher::touchesFile(size_t bytes) const
+{
+    for (size_t offset = 0; offset + sizeof(inotify_event) <= bytes;)
+    {
+        inotify_event event;
+        std::memcpy(&event, _buffer + offset, sizeof(event));
+        if (event.len > 0 && _fileName == _buffer + offset + sizeof(inotify_event))
+            return true;
+        offset += sizeof(inotify_event) + event.len;
+    }
+    return false;
+}
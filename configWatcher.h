@@ -0,0 +1,45 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace net = boost::asio;
+
+// Calls onChange on its own thread when file at path is written or replaced, nothing is polled or parsed in between.
+// inotify descriptor is read through asio. The directory is watched, not the file: editors usually save by renaming a temp file over it.
+// Events of one save (e.g. several close_write) are coalesced within c_debounce.
+class ConfigWatcher
+{
+public:
+    // Throws std::system_error when inotify is not available.
+    ConfigWatcher(const std::string& path, std::function<void()> onChange);
+
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+private:
+    void read();
+
+    // True if events in first bytes of _buffer name the watched file.
+    bool touchesFile(size_t bytes) const;
+
+private:
+    static constexpr auto c_debounce = std::chrono::milliseconds(20);
+
+    net::io_context _ioc{ 1 };
+    net::posix::stream_descriptor _descriptor;
+    net::steady_timer _debounce;
+    std::string _fileName;
+    std::function<void()> _onChange;
+    alignas(8) char _buffer[4096];
+    bool _pending = false;
+    std::thread _thread;
+};
@@ -0,0 +1,104 @@
+#include "connectionScheduler.h"
+
+#include <boost/asio/post.hpp>
+
+#include <spdlog/spdlog.h>
+
+ConnectionScheduler::ConnectionScheduler(net::io_context& ioc, size_t maxInFlight, double connectsPerSecond)
+    : _ioc(ioc)
+    , _timer(ioc)
+    , _maxInFlight(std::max<size_t>(maxInFlight, 1))
+    , _connectsPerSecond(std::max(connectsPerSecond, 0.01))
+    , _tokens(1.0)
+    , _lastRefill(std::chrono::steady_clock::now())
+{
+}
+
+void ConnectionScheduler::submit(std::function<void()> start)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_pending.empty() && _inFlight == 0)
+        {
+            _rampStart = std::chrono::steady_clock::now();
+            _rampConnected = 0;
+            _rampFailed = 0;
+        }
+        _pending.push_back(std::move(start));
+    }
+    net::post(_ioc, [this]() { pump(); });
+}
+
+void ConnectionScheduler::finished(bool connected)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_inFlight > 0)
+            --_inFlight;
+        connected ? ++_rampConnected : ++_rampFailed;
+
+        if (_pending.empty() && _inFlight == 0)
+        {
+            const auto rampMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _rampStart).count();
+            _lastRampMs = rampMs;
+            spdlog::info("Time to all connected: {} ms ({} connected, {} failed)", rampMs, _rampConnected, _rampFailed);
+        }
+    }
+    net::post(_ioc, [this]() { pump(); });
+}
+
+size_t ConnectionScheduler::inFlight()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _inFlight;
+}
+
+size_t ConnectionScheduler::queued()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending.size();
+}
+
+void ConnectionScheduler::refillTokens(std::chrono::steady_clock::time_point now)
+{
+    // Burst is capped to one second worth of budget.
+    const double elapsed = std::chrono::duration<double>(now - _lastRefill).count();
+    _tokens = std::min(std::max(_connectsPerSecond, 1.0), _tokens + elapsed * _connectsPerSecond);
+    _lastRefill = now;
+}
+
+void ConnectionScheduler::pump()
+{
+    std::vector<std::function<void()>> admitted;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        refillTokens(std::chrono::steady_clock::now());
+        while (!_pending.empty() && _inFlight < _maxInFlight && _tokens >= 1.0)
+        {
+            admitted.push_back(std::move(_pending.front()));
+            _pending.pop_front();
+            ++_inFlight;
+            _tokens -= 1.0;
+        }
+
+        // Out of budget: come back when next token is available. Slots freed by finished() pump by themselves.
+        if (!_pending.empty() && _inFlight < _maxInFlight && !_timerArmed)
+        {
+            _timerArmed = true;
+            const auto wait = std::chrono::duration<double>((1.0 - _tokens) / _connectsPerSecond);
+            _timer.expires_after(std::chrono::duration_cast<std::chrono::steady_clock::duration>(wait));
+            _timer.async_wait([this](const boost::system::error_code& ec)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _timerArmed = false;
+                }
+                if (!ec)
+                    pump();
+            });
+        }
+    }
+
+    for (auto& start : admitted)
+        start();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace net = boost::asio;
+
+// Admission control for connection attempts (resolve + connect + TLS and websocket handshakes).
+// At most maxInFlight attempts run at once and new ones start at no more than connectsPerSecond,
+// so ramp up and reconnect storms stay below exchange connection rate limits.
+// Attempts are admitted in submission order, manager submits them in config order.
+class ConnectionScheduler
+{
+public:
+    ConnectionScheduler(net::io_context& ioc, size_t maxInFlight, double connectsPerSecond);
+
+    // Thread safe. start runs on scheduler's io_context once admitted, every admitted attempt must call finished() exactly once.
+    void submit(std::function<void()> start);
+
+    // Thread safe.
+    void finished(bool connected);
+
+    // Duration of the last ramp: from first submission after idle until nothing was pending nor in flight.
+    std::chrono::milliseconds lastTimeToAllConnected() const { return std::chrono::milliseconds(_lastRampMs.load()); }
+
+    // Thread safe. Admitted attempts that did not finish yet.
+    size_t inFlight();
+
+    // Thread safe. Attempts waiting for a slot or rate budget.
+    size_t queued();
+
+private:
+    void pump();
+
+    void refillTokens(std::chrono::steady_clock::time_point now);
+
+private:
+    net::io_context& _ioc;
+    net::steady_timer _timer;
+    std::mutex _mutex;
+    std::deque<std::function<void()>> _pending;
+    size_t _maxInFlight = 0;
+    size_t _inFlight = 0;
+    double _connectsPerSecond = 0.0;
+    double _tokens = 0.0;
+    bool _timerArmed = false;
+    std::chrono::steady_clock::time_point _lastRefill;
+    std::chrono::steady_clock::time_point _rampStart;
+    size_t _rampConnected = 0;
+    size_t _rampFailed = 0;
+    std::atomic<int64_t> _lastRampMs = 0;
+};
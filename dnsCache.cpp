@@ -0,0 +1,89 @@
+#include "dnsCache.h"
+
+#include <boost/asio/execution/outstanding_work.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/prefer.hpp>
+
+#include <spdlog/spdlog.h>
+
+DnsCache& DnsCache::instance()
+{
+    static DnsCache cache;
+    return cache;
+}
+
+DnsCache::DnsCache() 
+    : _work(net::make_work_guard(_ioc))
+    , _resolver(_ioc)
+{
+    _thread = std::thread([this]() { _ioc.run(); });
+}
+
+DnsCache::~DnsCache()
+{
+    _work.reset();
+    _ioc.stop();
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void DnsCache::asyncResolve(const std::string& host, const std::string& port, const net::any_io_executor& executor, Handler handler)
+{
+    const std::string key = host + ":" + port;
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    Entry& entry = _entries[key];
+    const bool hasResults = !entry.results.empty();
+    const auto age = now - entry.resolvedAt;
+
+    if (hasResults && age < _ttl)
+    {
+        if (age > std::chrono::duration_cast<std::chrono::steady_clock::duration>(_ttl * c_refreshAhead) && !entry.inFlight)
+            startLookup(key, entry, host, port);
+
+        net::post(executor, [handler = std::move(handler), results = entry.results]() { handler({}, results); });
+        return;
+    }
+
+    // Tracked executor keeps caller's io_context from running out of work while lookup is in flight.
+    entry.waiters.emplace_back(net::prefer(executor, net::execution::outstanding_work.tracked), std::move(handler));
+    if (!entry.inFlight)
+        startLookup(key, entry, host, port);
+}
+
+void DnsCache::startLookup(const std::string& key, Entry& entry, const std::string& host, const std::string& port)
+{
+    entry.inFlight = true;
+    _resolver.async_resolve(host, port, [this, key](const boost::system::error_code& ec, Results results)
+    {
+        onLookup(key, ec, results);
+    });
+}
+
+void DnsCache::onLookup(const std::string& key, const boost::system::error_code& ec, const Results& results)
+{
+    std::vector<std::pair<net::any_io_executor, Handler>> waiters;
+    Results served;
+    boost::system::error_code servedEc = ec;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Entry& entry = _entries[key];
+        entry.inFlight = false;
+        if (!ec)
+        {
+            entry.results = results;
+            entry.resolvedAt = std::chrono::steady_clock::now();
+        }
+        else if (!entry.results.empty())
+        {
+            spdlog::warn("Resolve {} failed: {}. Using last known endpoints.", key, ec.message());
+            servedEc = {};
+        }
+        served = entry.results;
+        waiters.swap(entry.waiters);
+    }
+
+    for (auto& [executor, handler] : waiters)
+        net::post(executor, [handler = std::move(handler), servedEc, served]() { handler(servedEc, served); });
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace net = boost::asio;
+
+// Process wide resolver cache shared by stream and REST connections.
+// - fresh entries are served without any lookup,
+// - concurrent requests for the same host:port share one lookup,
+// - entries close to expiry are refreshed in background while still being served,
+// - when a lookup fails, last known endpoints are used instead of failing every waiter.
+class DnsCache
+{
+public:
+    using Results = net::ip::tcp::resolver::results_type;
+    using Handler = std::function<void(const boost::system::error_code&, const Results&)>;
+
+    static DnsCache& instance();
+
+    ~DnsCache();
+
+    // Handler is always invoked through executor, never inline.
+    void asyncResolve(const std::string& host, const std::string& port, const net::any_io_executor& executor, Handler handler);
+
+    void setTtl(std::chrono::seconds ttl) { std::lock_guard<std::mutex> lock(_mutex); _ttl = ttl; }
+
+private:
+    DnsCache();
+
+    struct Entry
+    {
+        Results results;
+        std::chrono::steady_clock::time_point resolvedAt;
+        bool inFlight = false;
+        std::vector<std::pair<net::any_io_executor, Handler>> waiters;
+    };
+
+    void startLookup(const std::string& key, Entry& entry, const std::string& host, const std::string& port);
+
+    void onLookup(const std::string& key, const boost::system::error_code& ec, const Results& results);
+
+private:
+    // Background refresh starts once entry is older than this part of ttl.
+    static constexpr double c_refreshAhead = 0.75;
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, Entry> _entries;
+    std::chrono::seconds _ttl{ 60 };
+    net::io_context _ioc;
+    net::executor_work_guard<net::io_context::executor_type> _work;
+    net::ip::tcp::resolver _resolver;
+    std::thread _thread;
+};
@@ -1,64 +1,127 @@
 #pragma once
 #include "Event.h"
 #include "webSocketsManager.h"
+#include "tlsSessionCache.h"
 
 template<typename TSession>
 struct DownloadOnTimerEvent : Event
 {
-    DownloadOnTimerEvent() = default;
-    DownloadOnTimerEvent(size_t timeOut, const std::string& symbolsPath, const std::string& host, const std::string& port) 
+    DownloadOnTimerEvent(size_t timeOut, ExchangeInfoStore& store, const std::string& host, const std::string& port) 
     : _timeOut(timeOut)
-    , _symbolsPath(symbolsPath)
+    , _store(store)
     , _host(host)
     , _port(port) 
     {
         _ctx.set_verify_mode(ssl::verify_peer);
         _ctx.load_verify_file("cacert.pem"); // Download cacert.pem from:  https://curl.se/docs/caextract.html
+        TlsSessionCache::instance().attach(_ctx); // refreshes resume TLS session of previous tick
     }
 
+    // Timer and both REST clients share one io_context, nothing blocks it: a slow download no longer delays the next tick.
     void downloadExchangeInfo()
     {
-        boost::asio::io_context ioc;
-        boost::asio::steady_timer timer(ioc, std::chrono::seconds(0)); // Initial delay = 0
-        std::function<void(const boost::beast::error_code&)>timer_callback = [this, &timer, &timer_callback](const boost::beast::error_code& error) // note dangle may occure if not carefull
-        {
-            if (!error) 
-            {
-                runBinanceSession();
-                timer.expires_at(timer.expiry() + std::chrono::seconds(_timeOut));
-                timer.async_wait(timer_callback);
-            }
-            else
-            {
-                 spdlog::error("Timer error: {}", error.message());
-            }
-        };
-        timer.async_wait(timer_callback); 
-        ioc.run();
+        _timer.expires_after(std::chrono::seconds(0)); // Initial delay = 0
+        _timer.async_wait([this](const boost::beast::error_code& error) { onTimer(error); });
+        _ioc.run();
     }
 
+    // Starts downloads of this tick and returns, completion is signalled through the event.
     void runBinanceSession() 
     {
-        boost::asio::io_context ioc;
+        if (_exchangeInfoClient.busy() || _timeClient.busy())
+        {
+            spdlog::warn("Previous exchangeinfo download is still running, skip this tick");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_settingsMutex);
+            _exchangeInfoClient.setEndpoint(_host, _port);
+            _timeClient.setEndpoint(_host, _port);
+            _exchangeInfoClient.setTimeouts(_requestTimeout, _idleTimeout);
+            _timeClient.setTimeouts(_requestTimeout, _idleTimeout);
+        }
 
-        // Create new session each time executed, since it is new session..
-        TSession session(ioc, _ctx, _host, _port, _symbolsPath, this); // pass "this" as event to update
         spdlog::info("Try to get exchangeinfo");
-        session.run();
-        ioc.run(); // Blocks session
+        _session.run();
+        _timeSession.run(); // refresh clock offset for latency stats
     }
 
+    // Thread safe. New period counts from the last tick and replaces the pending wait right away.
     void setTimeOut(size_t sec)
     {
-        _timeOut = sec;
+        if (_timeOut.exchange(sec) == sec)
+            return;
+
+        boost::asio::post(_ioc, [this]()
+        {
+            if (_lastTick != std::chrono::steady_clock::time_point{})
+                armTimer();
+        });
+    }
+
+    // Used from the next download on, connections to the previous endpoint are closed then.
+    void setEndpoint(const std::string& host, const std::string& port)
+    {
+        std::lock_guard<std::mutex> lock(_settingsMutex);
+        _host = host;
+        _port = port;
+    }
+
+    // Deadline of a whole request and longest silence of the server within it, used from the next download on.
+    void setRequestTimeouts(std::chrono::milliseconds request, std::chrono::milliseconds idle)
+    {
+        std::lock_guard<std::mutex> lock(_settingsMutex);
+        _requestTimeout = request;
+        _idleTimeout = idle;
+    }
+
+    // Call before downloadExchangeInfo() starts, context is shared with running sessions afterwards.
+    void addTrustedCertificates(const std::string& file)
+    {
+        _ctx.load_verify_file(file);
+    }
+
+private:
+    void onTimer(const boost::beast::error_code& error)
+    {
+        if (error == boost::asio::error::operation_aborted)
+            return; // re-armed by setTimeOut()
+        if (error)
+        {
+            spdlog::error("Timer error: {}", error.message());
+            return;
+        }
+
+        _lastTick = _timer.expiry();
+        runBinanceSession();
+        armTimer();
+    }
+
+    void armTimer()
+    {
+        _timer.expires_at(_lastTick + std::chrono::seconds(_timeOut.load()));
+        _timer.async_wait([this](const boost::beast::error_code& error) { onTimer(error); });
     }
 
 private:
-    size_t _timeOut = 0;
+    std::atomic<size_t> _timeOut = 0;
+    ExchangeInfoStore& _store;
 
+    std::mutex _settingsMutex;
     std::string _host;
     std::string _port;
-    std::string _symbolsPath;
+    std::chrono::milliseconds _requestTimeout{ 15000 };
+    std::chrono::milliseconds _idleTimeout{ 5000 };
 
     boost::asio::ssl::context _ctx{ ssl::context::tlsv12_client };
+
+    // Runs timer and downloads on the thread of downloadExchangeInfo().
+    boost::asio::io_context _ioc;
+    RestClient _exchangeInfoClient{ _ioc, _ctx };
+    RestClient _timeClient{ _ioc, _ctx };
+    boost::asio::steady_timer _timer{ _ioc };
+    std::chrono::steady_clock::time_point _lastTick;
+    TSession _session{ _exchangeInfoClient, _store, this }; // pass "this" as event to update
+    ServerTimeSession _timeSession{ _timeClient };
 };
@@ -0,0 +1,146 @@
+#include "exchangeInfoStore.h"
+#include "metrics.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+ExchangeInfoStore::~ExchangeInfoStore()
+{
+    if (_snapshotWrite.valid())
+        _snapshotWrite.wait();
+}
+
+void ExchangeInfoStore::setSnapshotFile(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _snapshotFile = path;
+}
+
+bool ExchangeInfoStore::loadSnapshotFile()
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_latest)
+            return true;
+        path = _snapshotFile;
+    }
+    if (path.empty() || !std::ifstream(path).good())
+        return false;
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->securities = Parser::parseExchangeInfoFile(path);
+    if (snapshot->securities.empty())
+        return false;
+    for (const auto& security : snapshot->securities)
+        snapshot->symbols.push_back(security.symbol);
+    snapshot->version = 1;
+
+    spdlog::info("Loaded {} symbols from exchangeInfo snapshot {}", snapshot->symbols.size(), path);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_latest)
+        _latest = std::move(snapshot);
+    return true;
+}
+
+uint64_t ExchangeInfoStore::contentHash(std::string_view body)
+{
+    constexpr std::string_view c_serverTime = "\"serverTime\":";
+    const size_t key = body.find(c_serverTime);
+    if (key == std::string_view::npos)
+        return std::hash<std::string_view>{}(body);
+
+    size_t valueEnd = key + c_serverTime.size();
+    while (valueEnd < body.size() && body[valueEnd] != ',' && body[valueEnd] != '}')
+        ++valueEnd;
+    const size_t before = std::hash<std::string_view>{}(body.substr(0, key));
+    const size_t after = std::hash<std::string_view>{}(body.substr(valueEnd));
+    return before ^ (after + 0x9e3779b97f4a7c15ULL + (before << 6) + (before >> 2));
+}
+
+bool ExchangeInfoStore::publish(std::string body, std::string etag, std::string lastModified)
+{
+    const uint64_t hash = contentHash(body);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_latest && _latest->hash == hash)
+        {
+            _etag = std::move(etag);
+            _lastModified = std::move(lastModified);
+            Metrics::instance().recordExchangeInfoUnchanged();
+            return false;
+        }
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->securities = Parser::parseExchangeInfo(body);
+    if (snapshot->securities.empty())
+    {
+        spdlog::error("exchangeInfo response without TRADING symbols ({} bytes), keeping previous one", body.size());
+        return false;
+    }
+    snapshot->symbols.reserve(snapshot->securities.size());
+    for (const auto& security : snapshot->securities)
+        snapshot->symbols.push_back(security.symbol);
+    snapshot->hash = hash;
+
+    // Validators are kept only with an accepted document: a 304 to them must mean "still the snapshot we hold".
+    std::lock_guard<std::mutex> lock(_mutex);
+    _etag = std::move(etag);
+    _lastModified = std::move(lastModified);
+    snapshot->version = _latest ? _latest->version + 1 : 1;
+    spdlog::info("exchangeInfo changed: version {}, {} TRADING symbols", snapshot->version, snapshot->symbols.size());
+    _latest = std::move(snapshot);
+    if (!_snapshotFile.empty())
+        writeSnapshot(std::make_shared<const std::string>(std::move(body)));
+    return true;
+}
+
+void ExchangeInfoStore::notModified()
+{
+    Metrics::instance().recordExchangeInfoUnchanged();
+}
+
+std::shared_ptr<const ExchangeInfoStore::Snapshot> ExchangeInfoStore::latest() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _latest;
+}
+
+std::string ExchangeInfoStore::etag() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _etag;
+}
+
+std::string ExchangeInfoStore::lastModified() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _lastModified;
+}
+
+void ExchangeInfoStore::writeSnapshot(std::shared_ptr<const std::string> body)
+{
+    // Called under _mutex. Documents change rarely, so waiting for the previous write is practically free.
+    if (_snapshotWrite.valid())
+        _snapshotWrite.wait();
+
+    _snapshotWrite = std::async(std::launch::async, [path = _snapshotFile, body = std::move(body)]()
+    {
+        // Written next to the target and renamed, so a reader never sees half a file.
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.write(body->data(), body->size()))
+            {
+                spdlog::error("Failed to write exchangeInfo snapshot {}", temporary);
+                return;
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+            spdlog::error("Failed to replace exchangeInfo snapshot {}", path);
+    });
+}
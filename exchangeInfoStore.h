@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parser.h"
+
+// Latest exchangeInfo, published by the download thread straight from the response body and read by the update thread.
+// Body is hashed first: an unchanged document costs one hash compare, it is parsed only when the hash differs.
+// Optionally every new version is written to a snapshot file in the background, it is loaded on start if download is not possible.
+class ExchangeInfoStore
+{
+public:
+    struct Snapshot
+    {
+        std::vector<SecurityInfo> securities;
+        // Ids of securities in exchangeInfo order.
+        std::vector<SymbolId> symbols;
+        uint64_t hash = 0;
+        // Increases with every changed document, starts at 1.
+        uint64_t version = 0;
+    };
+
+    ~ExchangeInfoStore();
+
+    // Empty path disables the snapshot file.
+    void setSnapshotFile(const std::string& path);
+
+    // Parses the snapshot file if nothing was published yet. True if a snapshot is available afterwards.
+    bool loadSnapshotFile();
+
+    // Body of a 200 response with its validators (empty if server did not send them). True if content changed.
+    bool publish(std::string body, std::string etag, std::string lastModified);
+
+    // Server answered 304 to the validators of the latest snapshot.
+    void notModified();
+
+    std::shared_ptr<const Snapshot> latest() const;
+
+    // Validators for the next conditional GET (If-None-Match / If-Modified-Since).
+    std::string etag() const;
+
+    std::string lastModified() const;
+
+    // serverTime changes on every response, it does not take part in the hash.
+    static uint64_t contentHash(std::string_view body);
+
+private:
+    void writeSnapshot(std::shared_ptr<const std::string> body);
+
+private:
+    mutable std::mutex _mutex;
+    std::shared_ptr<const Snapshot> _latest;
+    std::string _etag;
+    std::string _lastModified;
+    std::string _snapshotFile;
+    // At most one write in flight, a newer one waits for it.
+    std::future<void> _snapshotWrite;
+};
@@ -0,0 +1,240 @@
+#include "feedCapture.h"
+
+#include <spdlog/spdlog.h>
+
+#include <charconv>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FeedCapture::FeedCapture(const std::string& path, size_t shards) : _shards(std::max<size_t>(shards, 1))
+{
+    _file = std::fopen(path.c_str(), "ab");
+    if (!_file)
+        throw std::runtime_error("can not open capture file " + path + ": " + std::strerror(errno));
+
+    // Appending to an existing capture keeps one header at the start only.
+    if (std::ftell(_file) == 0)
+    {
+        capture::FileHeader header{};
+        std::memcpy(header.magic, capture::c_magic, sizeof(header.magic));
+        header.version = capture::c_version;
+        std::fwrite(&header, sizeof(header), 1, _file);
+    }
+
+    for (auto& shard : _shards)
+        shard.chunk = takeFreeChunk();
+    _writer = std::thread([this]() { writeLoop(); });
+    spdlog::info("Capturing received frames to {}", path);
+}
+
+FeedCapture::~FeedCapture()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& shard : _shards)
+        {
+            if (shard.chunk && !shard.chunk->data.empty())
+                _full.push_back(std::move(shard.chunk));
+        }
+        _stopping = true;
+    }
+    _ready.notify_one();
+    if (_writer.joinable())
+        _writer.join();
+    std::fclose(_file);
+}
+
+void FeedCapture::append(size_t shard, int64_t receivedNs, std::string_view symbol, std::string_view frame)
+{
+    Shard& state = _shards[shard % _shards.size()];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    uint32_t id = 0;
+    if (!symbolId(state, symbol, receivedNs, id))
+        return; // counted as dropped
+    write(state, receivedNs, id, frame);
+}
+
+bool FeedCapture::symbolId(Shard& shard, std::string_view symbol, int64_t receivedNs, uint32_t& id)
+{
+    if (auto it = shard.symbols.find(symbol); it != shard.symbols.end())
+    {
+        id = it->second;
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_symbolsMutex);
+        id = _symbolIds.try_emplace(std::string(symbol), static_cast<uint32_t>(_symbolIds.size())).first->second;
+    }
+    char definition[64];
+    auto [end, ec] = std::to_chars(definition, definition + 16, id);
+    *end++ = '\t';
+    const size_t length = std::min<size_t>(symbol.size(), definition + sizeof(definition) - end);
+    std::memcpy(end, symbol.data(), length);
+    if (!write(shard, receivedNs, capture::c_symbolDefinition, std::string_view(definition, end + length - definition)))
+        return false;
+
+    shard.symbols.emplace(symbol, id);
+    return true;
+}
+
+bool FeedCapture::write(Shard& shard, int64_t receivedNs, uint32_t symbolId, std::string_view payload)
+{
+    const size_t recordSize = sizeof(capture::RecordHeader) + payload.size();
+    // Pool was exhausted on the last hand-off (or writer took the chunk): the writer may have freed one since.
+    if (!shard.chunk)
+        shard.chunk = takeFreeChunk();
+    Chunk* chunk = shard.chunk.get();
+    if (chunk && (chunk->data.size() + recordSize > chunk->data.capacity() || (!chunk->data.empty() && receivedNs - chunk->firstNs > c_chunkMaxAgeNs)))
+    {
+        handOff(shard);
+        chunk = shard.chunk.get();
+    }
+    if (!chunk || recordSize > chunk->data.capacity())
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (chunk->data.empty())
+        chunk->firstNs = receivedNs;
+    const capture::RecordHeader header{ receivedNs, symbolId, static_cast<uint32_t>(payload.size()) };
+    const size_t offset = chunk->data.size();
+    chunk->data.resize(offset + recordSize); // within reserved capacity, no reallocation
+    std::memcpy(chunk->data.data() + offset, &header, sizeof(header));
+    std::memcpy(chunk->data.data() + offset + sizeof(header), payload.data(), payload.size());
+    return true;
+}
+
+bool FeedCapture::handOff(Shard& shard)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (shard.chunk)
+            _full.push_back(std::move(shard.chunk));
+    }
+    _ready.notify_one();
+    shard.chunk = takeFreeChunk();
+    return shard.chunk != nullptr;
+}
+
+std::unique_ptr<FeedCapture::Chunk> FeedCapture::takeFreeChunk()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_free.empty())
+    {
+        auto chunk = std::move(_free.back());
+        _free.pop_back();
+        return chunk;
+    }
+    if (_chunks >= c_maxChunks)
+        return nullptr;
+
+    ++_chunks;
+    auto chunk = std::make_unique<Chunk>();
+    chunk->data.reserve(c_chunkSize);
+    return chunk;
+}
+
+void FeedCapture::flushAgedChunks()
+{
+    const int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    for (auto& shard : _shards)
+    {
+        // Same lock order as append(): shard first, then _mutex, so chunks of a shard reach _full in order.
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        if (!shard.chunk || shard.chunk->data.empty() || nowNs - shard.chunk->firstNs <= c_chunkMaxAgeNs)
+            continue;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _full.push_back(std::move(shard.chunk));
+    }
+}
+
+void FeedCapture::writeLoop()
+{
+    constexpr auto c_sweepInterval = std::chrono::nanoseconds(c_chunkMaxAgeNs);
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto nextSweep = std::chrono::steady_clock::now() + c_sweepInterval;
+    while (true)
+    {
+        _ready.wait_until(lock, nextSweep, [this]() { return _stopping || !_full.empty(); });
+        if (!_stopping && std::chrono::steady_clock::now() >= nextSweep)
+        {
+            lock.unlock();
+            flushAgedChunks();
+            lock.lock();
+            nextSweep = std::chrono::steady_clock::now() + c_sweepInterval;
+        }
+        if (_full.empty())
+        {
+            if (_stopping)
+                break;
+            continue;
+        }
+
+        auto chunk = std::move(_full.front());
+        _full.pop_front();
+        lock.unlock();
+
+        if (std::fwrite(chunk->data.data(), 1, chunk->data.size(), _file) != chunk->data.size())
+            spdlog::error("Capture write failed: {}", std::strerror(errno));
+        std::fflush(_file);
+        chunk->data.clear();
+
+        lock.lock();
+        _free.push_back(std::move(chunk));
+    }
+}
+
+CaptureReader::CaptureReader(const std::string& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        spdlog::error("Can not open capture {}: {}", path, std::strerror(errno));
+        return;
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(capture::FileHeader))
+    {
+        void* mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED)
+        {
+            ::madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+            _data = static_cast<const char*>(mapped);
+            _size = st.st_size;
+        }
+    }
+    ::close(fd);
+
+    if (_data && std::memcmp(_data, capture::c_magic, sizeof(capture::c_magic)) != 0)
+    {
+        spdlog::error("{} is not a capture file", path);
+        ::munmap(const_cast<char*>(_data), _size);
+        _data = nullptr;
+        _size = 0;
+    }
+}
+
+CaptureReader::~CaptureReader()
+{
+    if (_data)
+        ::munmap(const_cast<char*>(_data), _size);
+}
+
+void CaptureReader::define(std::string_view definition)
+{
+    const size_t tab = definition.find('\t');
+    uint32_t id = 0;
+    if (tab == std::string_view::npos || std::from_chars(definition.data(), definition.data() + tab, id).ec != std::errc{})
+        return;
+
+    if (id >= _symbols.size())
+        _symbols.resize(id + 1);
+    _symbols[id] = definition.substr(tab + 1);
+}
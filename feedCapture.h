@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Binary append-only capture of received frames:
+//   FileHeader, then records: RecordHeader followed by `length` payload bytes.
+// Symbol ids are defined in-band: a record with symbolId == c_symbolDefinition carries "<id>\t<symbol>" and precedes
+// the first frame of that symbol written by the same io thread (several io threads may define the same id, always with the same symbol).
+namespace capture
+{
+    constexpr char c_magic[8] = { 'S', 'C', 'R', 'P', 'C', 'A', 'P', '1' };
+    constexpr uint32_t c_version = 1;
+    constexpr uint32_t c_symbolDefinition = 0xFFFFFFFF;
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+    };
+
+    struct RecordHeader
+    {
+        int64_t receivedNs; // system clock
+        uint32_t symbolId;
+        uint32_t length;
+    };
+}
+
+// Capture writer. io threads append records into their own chunk (memcpy only, no syscalls);
+// full or old chunks are handed to a writer thread that does the buffered file IO.
+// Shard lock is uncontended but for the writer taking chunks of quiet shards once they are older than c_chunkMaxAgeNs.
+class FeedCapture
+{
+public:
+    FeedCapture(const std::string& path, size_t shards);
+
+    ~FeedCapture();
+
+    FeedCapture(const FeedCapture&) = delete;
+    FeedCapture& operator=(const FeedCapture&) = delete;
+
+    // io thread of the shard only. frame is the whole combined stream message.
+    void append(size_t shard, int64_t receivedNs, std::string_view symbol, std::string_view frame);
+
+    uint64_t droppedFrames() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    // Chunk is handed over when full or when its first record is older than this.
+    static constexpr size_t c_chunkSize = 1 << 20;
+    static constexpr int64_t c_chunkMaxAgeNs = 1000000000;
+    // Frames are dropped (and counted) instead of growing memory when the disk can not keep up.
+    static constexpr size_t c_maxChunks = 64;
+
+    struct Chunk
+    {
+        std::vector<char> data;
+        int64_t firstNs = 0;
+    };
+
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        // Null when no free chunk was left or the writer took an aged one, next append takes another.
+        std::unique_ptr<Chunk> chunk;
+        // Symbols this shard already defined in the file, transparent lookup does not allocate.
+        struct Hash { using is_transparent = void; size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); } };
+        std::unordered_map<std::string, uint32_t, Hash, std::equal_to<>> symbols;
+    };
+
+    // Defines the symbol in this shard's stream first if needed, false when the definition could not be written.
+    bool symbolId(Shard& shard, std::string_view symbol, int64_t receivedNs, uint32_t& id);
+
+    bool write(Shard& shard, int64_t receivedNs, uint32_t symbolId, std::string_view payload);
+
+    bool handOff(Shard& shard);
+
+    std::unique_ptr<Chunk> takeFreeChunk();
+
+    // Writer thread. Hands over chunks no append handed over in time, e.g. the last one of a shard that went quiet.
+    void flushAgedChunks();
+
+    void writeLoop();
+
+private:
+    std::FILE* _file = nullptr;
+    std::vector<Shard> _shards;
+
+    std::mutex _symbolsMutex;
+    std::unordered_map<std::string, uint32_t> _symbolIds;
+
+    std::mutex _mutex;
+    std::condition_variable _ready;
+    std::deque<std::unique_ptr<Chunk>> _full;
+    std::vector<std::unique_ptr<Chunk>> _free;
+    size_t _chunks = 0;
+    bool _stopping = false;
+    std::atomic<uint64_t> _dropped = 0;
+    std::thread _writer;
+};
+
+// Read side: maps a whole capture file and iterates its records in file order.
+class CaptureReader
+{
+public:
+    explicit CaptureReader(const std::string& path);
+
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    bool isValid() const { return _data != nullptr; }
+
+    size_t size() const { return _size; }
+
+    // Calls f(receivedNs, symbolId, frame) for every frame record, symbol definitions are collected into symbols().
+    // Returns false when the file ends in the middle of a record (e.g. capture was killed), records before it are still passed.
+    template<typename F>
+    bool forEach(F&& f)
+    {
+        size_t offset = sizeof(capture::FileHeader);
+        while (offset + sizeof(capture::RecordHeader) <= _size)
+        {
+            capture::RecordHeader header;
+            std::memcpy(&header, _data + offset, sizeof(header));
+            offset += sizeof(header);
+            if (offset + header.length > _size)
+                return false;
+
+            const std::string_view payload(_data + offset, header.length);
+            offset += header.length;
+            if (header.symbolId == capture::c_symbolDefinition)
+                define(payload);
+            else
+                f(header.receivedNs, header.symbolId, payload);
+        }
+        return offset == _size;
+    }
+
+    // Same as forEach, but frames come in receivedNs order. The file is only ordered per io thread (each one hands over
+    // its own chunks), so frames of all shards are merged by timestamp first: an index of every frame is built on the first call.
+    template<typename F>
+    bool forEachInTimeOrder(F&& f)
+    {
+        if (!_timeOrderBuilt)
+        {
+            _timeOrderComplete = forEach([this](int64_t receivedNs, uint32_t, std::string_view frame)
+            {
+                _timeOrder.push_back({ receivedNs, static_cast<size_t>(frame.data() - _data) - sizeof(capture::RecordHeader) });
+            });
+            // Stable: frames of one shard with equal timestamps keep their file order.
+            std::stable_sort(_timeOrder.begin(), _timeOrder.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            _timeOrderBuilt = true;
+        }
+
+        for (const auto& [receivedNs, offset] : _timeOrder)
+        {
+            capture::RecordHeader header;
+            std::memcpy(&header, _data + offset, sizeof(header));
+            f(header.receivedNs, header.symbolId, std::string_view(_data + offset + sizeof(header), header.length));
+        }
+        return _timeOrderComplete;
+    }
+
+    const std::vector<std::string>& symbols() const { return _symbols; }
+
+private:
+    void define(std::string_view definition);
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+    std::vector<std::string> _symbols;
+    // receivedNs and record offset of every frame, sorted by time.
+    std::vector<std::pair<int64_t, size_t>> _timeOrder;
+    bool _timeOrderBuilt = false;
+    bool _timeOrderComplete = true;
+};
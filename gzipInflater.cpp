@@ -0,0 +1,51 @@
+#include "gzipInflater.h"
+
+#include <algorithm>
+
+GzipInflater::GzipInflater()
+{
+    // 32 + window bits: detect gzip or zlib header automatically.
+    inflateInit2(&_stream, 32 + MAX_WBITS);
+}
+
+GzipInflater::~GzipInflater()
+{
+    inflateEnd(&_stream);
+}
+
+void GzipInflater::reset()
+{
+    inflateReset(&_stream);
+    _finished = false;
+}
+
+bool GzipInflater::inflate(const char* data, size_t size, std::string& out, size_t limit)
+{
+    if (_finished)
+        return size == 0;
+
+    _stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    _stream.avail_in = static_cast<uInt>(size);
+    while (_stream.avail_in > 0)
+    {
+        // Inflate straight into the tail of out, no intermediate buffer.
+        const size_t used = out.size();
+        if (used >= limit)
+            return false;
+        const size_t growth = std::min(std::max(c_minGrowth, size_t(_stream.avail_in) * 8), limit - used);
+        out.resize(used + growth);
+        _stream.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+        _stream.avail_out = static_cast<uInt>(growth);
+
+        const int result = ::inflate(&_stream, Z_NO_FLUSH);
+        out.resize(used + growth - _stream.avail_out);
+        if (result == Z_STREAM_END)
+        {
+            _finished = true;
+            return _stream.avail_in == 0;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <zlib.h>
+
+#include <cstddef>
+#include <string>
+
+// Streaming inflate of a gzip (or zlib wrapped deflate) HTTP body, fed chunk by chunk as it arrives from the socket.
+class GzipInflater
+{
+public:
+    GzipInflater();
+    ~GzipInflater();
+
+    GzipInflater(const GzipInflater&) = delete;
+    GzipInflater& operator=(const GzipInflater&) = delete;
+
+    // Starts a new stream, state of the previous one is dropped.
+    void reset();
+
+    // Appends inflated bytes of data to out. False on corrupt input, data after the end of stream or out growing beyond limit.
+    bool inflate(const char* data, size_t size, std::string& out, size_t limit);
+
+    // True once the gzip trailer was checked, body is complete only then.
+    bool finished() const { return _finished; }
+
+private:
+    // Minimal growth of output per inflate() call, compressed JSON usually expands 5-15 times.
+    static constexpr size_t c_minGrowth = 64 * 1024;
+
+    z_stream _stream{};
+    bool _finished = false;
+};
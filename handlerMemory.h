@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Storage reused by every operation of one handler chain (e.g. read loop of a connection).
+// Asio frees operation state before it invokes the handler, so the next operation started from the handler finds the slot free again.
+// Bigger requests, or a request while the slot is taken, fall back to the heap.
+class HandlerMemory
+{
+public:
+    static constexpr size_t c_size = 1024;
+
+    HandlerMemory() = default;
+    HandlerMemory(const HandlerMemory&) = delete;
+    HandlerMemory& operator=(const HandlerMemory&) = delete;
+
+    void* allocate(size_t size)
+    {
+        if (!_inUse && size <= c_size)
+        {
+            _inUse = true;
+            return &_storage;
+        }
+        ++_heapAllocations;
+        return ::operator new(size);
+    }
+
+    void deallocate(void* pointer)
+    {
+        if (pointer == &_storage)
+            _inUse = false;
+        else
+            ::operator delete(pointer);
+    }
+
+    // Requests that did not fit into the slot, stays zero in steady state.
+    uint64_t heapAllocations() const { return _heapAllocations; }
+
+private:
+    std::aligned_storage_t<c_size, alignof(std::max_align_t)> _storage;
+    bool _inUse = false;
+    uint64_t _heapAllocations = 0;
+};
+
+// Minimal allocator over HandlerMemory, found by asio through associated_allocator of RecyclingHandler.
+template<typename T>
+class HandlerAllocator
+{
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory& memory) : _memory(&memory) {}
+
+    template<typename U>
+    HandlerAllocator(const HandlerAllocator<U>& other) noexcept : _memory(other._memory) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(_memory->allocate(sizeof(T) * n)); }
+
+    void deallocate(T* pointer, size_t) { _memory->deallocate(pointer); }
+
+    bool operator==(const HandlerAllocator& other) const noexcept { return _memory == other._memory; }
+    bool operator!=(const HandlerAllocator& other) const noexcept { return _memory != other._memory; }
+
+private:
+    template<typename> friend class HandlerAllocator;
+
+    HandlerMemory* _memory;
+};
+
+// Wraps a completion handler so intermediate and final operation state is placed into HandlerMemory.
+template<typename Handler>
+class RecyclingHandler
+{
+public:
+    using allocator_type = HandlerAllocator<Handler>;
+
+    RecyclingHandler(HandlerMemory& memory, Handler handler) : _memory(memory), _handler(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return allocator_type(_memory); }
+
+    template<typename... Args>
+    void operator()(Args&&... args) { _handler(std::forward<Args>(args)...); }
+
+private:
+    HandlerMemory& _memory;
+    Handler _handler;
+};
+
+template<typename Handler>
+RecyclingHandler<std::decay_t<Handler>> makeRecyclingHandler(HandlerMemory& memory, Handler&& handler)
+{
+    return RecyclingHandler<std::decay_t<Handler>>(memory, std::forward<Handler>(handler));
+}
@@ -0,0 +1,80 @@
+#include "ioContextPool.h"
+
+#include <spdlog/spdlog.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+IoContextPool::IoContextPool(size_t threads, bool pinThreads, bool busyPoll) : _pinThreads(pinThreads), _busyPoll(busyPoll)
+{
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        // Concurrency hint 1: each context is run by a single thread, so asio can skip internal locking.
+        _contexts.push_back(std::make_unique<net::io_context>(1));
+        // Keeps run() from returning while a shard has no connections yet (or all of them failed).
+        _guards.push_back(net::make_work_guard(*_contexts.back()));
+    }
+}
+
+IoContextPool::~IoContextPool()
+{
+    stop();
+}
+
+void IoContextPool::run()
+{
+    if (!_threads.empty())
+        return;
+
+    for (size_t i = 0; i < _contexts.size(); ++i)
+    {
+        _threads.emplace_back([this, i]()
+        {
+            if (_pinThreads)
+                pinCurrentThread(i);
+
+            try
+            {
+                if (_busyPoll)
+                {
+                    while (!_contexts[i]->stopped())
+                        _contexts[i]->poll();
+                }
+                else
+                {
+                    _contexts[i]->run();
+                }
+            }
+            catch (const std::exception& e)
+            {
+                spdlog::error("io thread {} stopped by exception: {}", i, e.what());
+            }
+        });
+    }
+    spdlog::info("Started {} io threads{}{}", _threads.size(), _pinThreads ? " pinned to cpus" : "", _busyPoll ? " busy polling" : "");
+}
+
+void IoContextPool::stop()
+{
+    _guards.clear();
+    for (auto& ctx : _contexts)
+        ctx->stop();
+
+    for (auto& thread : _threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    _threads.clear();
+}
+
+void IoContextPool::pinCurrentThread(size_t shard)
+{
+    const size_t cpus = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(shard % cpus, &cpuset);
+    if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset); rc != 0)
+        spdlog::warn("Failed to pin io thread {} to cpu {}: {}", shard, shard % cpus, strerror(rc));
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+
+// Fixed set of io_contexts, each one run by exactly one thread (optionally pinned to a CPU).
+// Everything that lives on a shard is only touched by that shard thread, so the per-message path needs no locks.
+// With busyPoll threads spin on poll() instead of sleeping in epoll_wait: no wake up latency, but each one burns a core.
+class IoContextPool
+{
+public:
+    IoContextPool(size_t threads, bool pinThreads, bool busyPoll = false);
+
+    ~IoContextPool();
+
+    IoContextPool(const IoContextPool&) = delete;
+    IoContextPool& operator=(const IoContextPool&) = delete;
+
+    void run();
+
+    void stop();
+
+    size_t size() const { return _contexts.size(); }
+
+    net::io_context& get(size_t shard) { return *_contexts[shard % _contexts.size()]; }
+
+    // Stable across runs and platforms (FNV-1a), so a symbol always lands on the same shard.
+    size_t shardOf(std::string_view symbol) const
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : symbol)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash % _contexts.size();
+    }
+
+private:
+    void pinCurrentThread(size_t shard);
+
+private:
+    using WorkGuard = net::executor_work_guard<net::io_context::executor_type>;
+
+    std::vector<std::unique_ptr<net::io_context>> _contexts;
+    std::vector<WorkGuard> _guards;
+    std::vector<std::thread> _threads;
+    bool _pinThreads = false;
+    bool _busyPoll = false;
+};
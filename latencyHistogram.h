@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Log-linear (HDR style) histogram of microsecond latencies: 8 linear sub-buckets per power of two,
+// so every value is kept with ~12% precision from 1 us up to ~70 minutes in under 2 KB.
+// Single writer: record() is called only by the owning io thread and uses plain relaxed stores, no locks or RMW.
+// Any thread may read it concurrently through snapshot()/merge.
+class LatencyHistogram
+{
+public:
+    static constexpr int c_subBucketBits = 3;
+    static constexpr uint64_t c_subBuckets = 1 << c_subBucketBits;
+    static constexpr int c_maxExponent = 31;
+    static constexpr size_t c_buckets = (c_maxExponent - c_subBucketBits + 1) * c_subBuckets + c_subBuckets;
+    static constexpr uint64_t c_maxValue = (uint64_t{ 1 } << (c_maxExponent + 1)) - 1;
+
+    struct Snapshot
+    {
+        void merge(const Snapshot& other)
+        {
+            for (size_t i = 0; i < c_buckets; ++i)
+                counts[i] += other.counts[i];
+            total += other.total;
+            max = std::max(max, other.max);
+        }
+
+        // Upper bound of the bucket holding the given percentile (0..100).
+        uint64_t percentile(double p) const
+        {
+            if (total == 0)
+                return 0;
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p / 100.0 * total + 0.5));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < c_buckets; ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                    return std::min(upperBound(i), max);
+            }
+            return max;
+        }
+
+        std::array<uint64_t, c_buckets> counts{};
+        uint64_t total = 0;
+        uint64_t max = 0;
+    };
+
+    void record(int64_t valueUs)
+    {
+        const uint64_t value = std::min<uint64_t>(valueUs > 0 ? valueUs : 0, c_maxValue);
+        auto& bucket = _counts[index(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        _total.store(_total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > _max.load(std::memory_order_relaxed))
+            _max.store(value, std::memory_order_relaxed);
+    }
+
+    void mergeInto(Snapshot& snapshot) const
+    {
+        for (size_t i = 0; i < c_buckets; ++i)
+            snapshot.counts[i] += _counts[i].load(std::memory_order_relaxed);
+        snapshot.total += _total.load(std::memory_order_relaxed);
+        snapshot.max = std::max(snapshot.max, _max.load(std::memory_order_relaxed));
+    }
+
+    static size_t index(uint64_t value)
+    {
+        if (value < c_subBuckets)
+            return value;
+        const int exponent = 63 - __builtin_clzll(value);
+        const int shift = exponent - c_subBucketBits;
+        return (shift + 1) * c_subBuckets + ((value >> shift) & (c_subBuckets - 1));
+    }
+
+    static uint64_t upperBound(size_t index)
+    {
+        if (index < c_subBuckets)
+            return index;
+        const int shift = static_cast<int>(index / c_subBuckets) - 1;
+        return ((c_subBuckets + index % c_subBuckets + 1) << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, c_buckets> _counts{};
+    std::atomic<uint64_t> _total = 0;
+    std::atomic<uint64_t> _max = 0;
+};
@@ -0,0 +1,135 @@
+#include "latencyStats.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <map>
+
+namespace
+{
+    struct Aggregate
+    {
+        LatencyHistogram::Snapshot exchangeToReceive;
+        LatencyHistogram::Snapshot receiveToDone;
+
+        void add(const SymbolLatency& latency)
+        {
+            latency.exchangeToReceive.mergeInto(exchangeToReceive);
+            latency.receiveToDone.mergeInto(receiveToDone);
+        }
+    };
+
+    void writeLine(std::ostream& out, const std::string& name, const Aggregate& aggregate)
+    {
+        auto write = [&out](const char* stage, const LatencyHistogram::Snapshot& s)
+        {
+            out << ' ' << stage << " n=" << s.total << " p50=" << s.percentile(50) << " p90=" << s.percentile(90)
+                << " p99=" << s.percentile(99) << " p99.9=" << s.percentile(99.9) << " max=" << s.max;
+        };
+        out << name;
+        write("exchange->receive(us)", aggregate.exchangeToReceive);
+        write("receive->done(us)", aggregate.receiveToDone);
+        out << '\n';
+    }
+}
+
+ClockOffsetEstimator& ClockOffsetEstimator::instance()
+{
+    static ClockOffsetEstimator estimator;
+    return estimator;
+}
+
+void ClockOffsetEstimator::addSample(int64_t serverTimeMs, int64_t sentNs, int64_t receivedNs)
+{
+    if (receivedNs < sentNs)
+        return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _samples.push_back({ serverTimeMs * 1000000 - (sentNs + receivedNs) / 2, receivedNs - sentNs });
+    if (_samples.size() > c_maxSamples)
+        _samples.pop_front();
+
+    const auto best = std::min_element(_samples.begin(), _samples.end(), [](const Sample& a, const Sample& b){ return a.roundTripNs < b.roundTripNs; });
+    _offsetNs = best->offsetNs;
+    _bestRoundTripNs = best->roundTripNs;
+    spdlog::info("Exchange clock offset {} us (round trip {} us)", best->offsetNs / 1000, best->roundTripNs / 1000);
+}
+
+LatencyRegistry& LatencyRegistry::instance()
+{
+    static LatencyRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<SymbolLatency> LatencyRegistry::add(const std::string& symbol, size_t shard, const void* connection)
+{
+    auto latency = std::make_shared<SymbolLatency>(symbol, shard, connection);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _symbols.push_back(latency);
+    return latency;
+}
+
+void LatencyRegistry::remove(const std::shared_ptr<SymbolLatency>& latency)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::erase(_symbols, latency);
+}
+
+void LatencyRegistry::dump(std::ostream& out)
+{
+    std::vector<std::shared_ptr<SymbolLatency>> symbols;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        symbols = _symbols;
+    }
+
+    Aggregate global;
+    std::map<size_t, Aggregate> shards;
+    std::map<const void*, Aggregate> connections;
+    for (const auto& latency : symbols)
+    {
+        global.add(*latency);
+        shards[latency->shard].add(*latency);
+        connections[latency->connection].add(*latency);
+    }
+
+    writeLine(out, "global", global);
+    for (const auto& [shard, aggregate] : shards)
+        writeLine(out, "shard " + std::to_string(shard), aggregate);
+    size_t connectionIndex = 0;
+    for (const auto& [connection, aggregate] : connections)
+        writeLine(out, "connection " + std::to_string(connectionIndex++), aggregate);
+    for (const auto& latency : symbols)
+    {
+        Aggregate aggregate;
+        aggregate.add(*latency);
+        writeLine(out, "symbol " + latency->symbol, aggregate);
+    }
+}
+
+void LatencyRegistry::logSummary()
+{
+    std::vector<std::shared_ptr<SymbolLatency>> symbols;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        symbols = _symbols;
+    }
+
+    Aggregate global;
+    std::map<size_t, Aggregate> shards;
+    for (const auto& latency : symbols)
+    {
+        global.add(*latency);
+        shards[latency->shard].add(*latency);
+    }
+
+    auto log = [](const std::string& name, const Aggregate& a)
+    {
+        spdlog::info("Latency {}: exchange->receive p50 {} us, p99 {} us, max {} us; receive->done p50 {} us, p99 {} us, max {} us ({} msgs)",
+            name, a.exchangeToReceive.percentile(50), a.exchangeToReceive.percentile(99), a.exchangeToReceive.max,
+            a.receiveToDone.percentile(50), a.receiveToDone.percentile(99), a.receiveToDone.max, a.receiveToDone.total);
+    };
+    log("global", global);
+    for (const auto& [shard, aggregate] : shards)
+        log("shard " + std::to_string(shard), aggregate);
+}
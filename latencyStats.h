@@ -0,0 +1,94 @@
+#pragma once
+
+#include "latencyHistogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+inline int64_t systemNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Estimates exchange clock minus local clock from server time samples (e.g. GET /api/v3/time).
+// Sample with the smallest round trip among recent ones wins: its midpoint is the closest to when server read its clock.
+class ClockOffsetEstimator
+{
+public:
+    static ClockOffsetEstimator& instance();
+
+    // serverTimeMs: exchange time in response; sentNs/receivedNs: local system clock around the request.
+    void addSample(int64_t serverTimeMs, int64_t sentNs, int64_t receivedNs);
+
+    // Safe to read from any thread on the hot path.
+    int64_t offsetNs() const { return _offsetNs.load(std::memory_order_relaxed); }
+
+    int64_t bestRoundTripNs() const { return _bestRoundTripNs.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t c_maxSamples = 16;
+
+    struct Sample
+    {
+        int64_t offsetNs;
+        int64_t roundTripNs;
+    };
+
+    std::mutex _mutex;
+    std::deque<Sample> _samples;
+    std::atomic<int64_t> _offsetNs = 0;
+    std::atomic<int64_t> _bestRoundTripNs = 0;
+};
+
+// Latency of one symbol, written only by the io thread that owns the symbol's connection.
+struct SymbolLatency
+{
+    SymbolLatency(std::string s, size_t sh, const void* c) : symbol(std::move(s)), shard(sh), connection(c) {}
+
+    // Exchange event time "E" (corrected by clock offset) -> frame received from socket.
+    void recordReceive(uint64_t eventTimeMs, int64_t receivedNs)
+    {
+        exchangeToReceive.record((receivedNs + ClockOffsetEstimator::instance().offsetNs()) / 1000 - static_cast<int64_t>(eventTimeMs) * 1000);
+    }
+
+    // Frame received -> strategy finished with it.
+    void recordDone(int64_t receivedNs, int64_t doneNs)
+    {
+        receiveToDone.record((doneNs - receivedNs) / 1000);
+    }
+
+    const std::string symbol;
+    const size_t shard;
+    const void* connection;
+    LatencyHistogram exchangeToReceive;
+    LatencyHistogram receiveToDone;
+};
+
+// Keeps per symbol histograms alive for dumps. Registration happens on subscribe/unsubscribe only,
+// message path just writes into its own SymbolLatency.
+class LatencyRegistry
+{
+public:
+    static LatencyRegistry& instance();
+
+    std::shared_ptr<SymbolLatency> add(const std::string& symbol, size_t shard, const void* connection);
+
+    void remove(const std::shared_ptr<SymbolLatency>& latency);
+
+    // Global, per shard, per connection and per symbol percentiles.
+    void dump(std::ostream& out);
+
+    // Short summary to log: global and per shard.
+    void logSummary();
+
+private:
+    std::mutex _mutex;
+    std::vector<std::shared_ptr<SymbolLatency>> _symbols;
+};
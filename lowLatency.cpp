@@ -0,0 +1,53 @@
+#include "lowLatency.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+void LowLatencyProfile::applyToSocket(boost::asio::ip::tcp::socket& socket) const
+{
+    if (!enabled)
+        return;
+
+    boost::system::error_code ec;
+    if (tcpNoDelay)
+    {
+        // Only control messages are written, but SUBSCRIBE must not wait for delayed ACK of the previous one.
+        socket.set_option(boost::asio::ip::tcp::no_delay(true), ec);
+        if (ec)
+            spdlog::warn("TCP_NODELAY: {}", ec.message());
+    }
+    if (receiveBufferBytes > 0)
+    {
+        socket.set_option(boost::asio::socket_base::receive_buffer_size(receiveBufferBytes), ec);
+        if (ec)
+            spdlog::warn("SO_RCVBUF {}: {}", receiveBufferBytes, ec.message());
+    }
+#ifdef SO_BUSY_POLL
+    if (busyPollUs > 0 && setsockopt(socket.native_handle(), SOL_SOCKET, SO_BUSY_POLL, &busyPollUs, sizeof(busyPollUs)) != 0)
+        spdlog::warn("SO_BUSY_POLL {} us: {}", busyPollUs, strerror(errno));
+#endif
+}
+
+void LowLatencyProfile::applyToProcess() const
+{
+    if (!enabled)
+        return;
+
+    if (lockMemory)
+    {
+        // Needs CAP_IPC_LOCK or a large enough "ulimit -l".
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+            spdlog::warn("mlockall: {}", strerror(errno));
+        else
+            spdlog::info("Process memory locked, no page faults from swapping on the hot path");
+    }
+    spdlog::info("Low latency profile: tcp_nodelay {}, rcvbuf {} bytes, busy_poll {} us, busy poll io loop {}, prefault buffers {}",
+        tcpNoDelay, receiveBufferBytes, busyPollUs, busyPollLoop, prefaultBuffers);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <boost/asio/ip/tcp.hpp>
+
+#include <cstddef>
+
+// Opt-in settings that trade CPU and memory for lower and steadier receive latency ([low_latency] in config.toml).
+struct LowLatencyProfile
+{
+    bool enabled = false;
+    bool tcpNoDelay = true;
+    int receiveBufferBytes = 4 * 1024 * 1024; // 0 - kernel default
+    int busyPollUs = 50;                      // SO_BUSY_POLL, 0 - off
+    bool busyPollLoop = false;                // io threads spin on poll() instead of sleeping in epoll
+    bool lockMemory = false;                  // mlockall(MCL_CURRENT | MCL_FUTURE)
+    bool prefaultBuffers = true;              // touch read buffers up front so first messages do not page fault
+
+    bool operator==(const LowLatencyProfile&) const = default;
+
+    // Applied right after TCP connect (async_connect over resolver results reopens the socket for every endpoint).
+    // Failures are only logged: e.g. SO_BUSY_POLL needs CAP_NET_ADMIN for values above net.core.busy_poll.
+    void applyToSocket(boost::asio::ip::tcp::socket& socket) const;
+
+    // Process wide part, call once before io threads start.
+    void applyToProcess() const;
+};
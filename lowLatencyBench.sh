@@ -0,0 +1,118 @@
+#!/bin/bash
+# Low latency profile on/off against the local feed generator ([low_latency] in config.toml, scrapper_mock_exchange).
+# Runs scrapper twice on the same mock feed, without and with the profile, and prints the latency dump of both runs.
+#
+#   ./lowLatencyBench.sh [--seconds 30] [--io-threads 2] [--symbols 200] [--rate 20] [--port 9543] [--busy-poll-io-loop]
+#
+# Run from the build directory (next to scrapper and scrapper_mock_exchange), needs openssl and taskset.
+# scrapper runs on cpus 0..io_threads-1 in both runs (with the profile every io thread is pinned to its own one of them),
+# the mock on the remaining cpus. With fewer than io_threads + 1 cpus they share cores and the numbers say nothing about the profile.
+
+set -euo pipefail
+
+seconds=30
+ioThreads=2
+symbols=200
+rate=20
+port=9543
+busyPollLoop=false
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --seconds) seconds=$2; shift ;;
+        --io-threads) ioThreads=$2; shift ;;
+        --symbols) symbols=$2; shift ;;
+        --rate) rate=$2; shift ;;
+        --port) port=$2; shift ;;
+        --busy-poll-io-loop) busyPollLoop=true ;;
+        *) echo "usage: $0 [--seconds 30] [--io-threads 2] [--symbols 200] [--rate 20] [--port 9543] [--busy-poll-io-loop]" >&2; exit 1 ;;
+    esac
+    shift
+done
+
+binDir=$(cd "$(dirname "$0")" && pwd)
+for binary in scrapper scrapper_mock_exchange; do
+    if [ ! -x "$binDir/$binary" ]; then
+        echo "$binDir/$binary not found, run the script from the build directory" >&2
+        exit 1
+    fi
+done
+
+cpus=$(nproc)
+scrapperCpus="0-$((ioThreads - 1))"
+mockCpus="$ioThreads-$((cpus - 1))"
+if [ "$cpus" -le "$ioThreads" ]; then
+    echo "WARNING: $cpus cpus for $ioThreads io threads and the mock, cores are shared and results are not representative" >&2
+    scrapperCpus="0-$((cpus - 1))"
+    mockCpus=$scrapperCpus
+fi
+
+work=$(mktemp -d)
+mockPid=""
+cleanup()
+{
+    if [ -n "$mockPid" ]; then
+        kill "$mockPid" 2>/dev/null || true
+        wait "$mockPid" 2>/dev/null || true
+    fi
+    rm -rf "$work"
+}
+trap cleanup EXIT
+
+openssl req -x509 -newkey rsa:2048 -nodes -keyout "$work/key.pem" -out "$work/cert.pem" -days 1 -subj "/CN=localhost" 2>/dev/null
+
+taskset -c "$mockCpus" "$binDir/scrapper_mock_exchange" --cert "$work/cert.pem" --key "$work/key.pem" --port "$port" \
+    --symbols "$symbols" --rate "$rate" --threads 1 > "$work/mock.log" 2>&1 &
+mockPid=$!
+sleep 1
+
+run()
+{
+    local mode=$1
+    local enabled=$2
+    local dir="$work/$mode"
+    mkdir -p "$dir"
+    cp "$work/cert.pem" "$dir/cacert.pem"
+    cat > "$dir/config.toml" <<EOF
+[main]
+    securities = []
+    timer = 30
+    filter = ""
+[network]
+    io_threads = $ioThreads
+    connects_per_second = 50.0
+[metrics]
+    port = 0
+[latency]
+    dump_interval_s = 0
+    dump_file = "latency.txt"
+[low_latency]
+    enabled = $enabled
+    busy_poll_io_loop = $busyPollLoop
+[endpoints]
+    rest_host = "localhost"
+    rest_port = $port
+    stream_host = "localhost"
+    stream_port = $port
+    ca_file = "cacert.pem"
+EOF
+
+    (cd "$dir" && exec taskset -c "$scrapperCpus" "$binDir/scrapper" > scrapper.log 2>&1) &
+    local pid=$!
+    sleep "$seconds"
+    # Dump is written by the update thread on SIGUSR1, give it a moment before stopping.
+    kill -USR1 "$pid" 2>/dev/null || true
+    sleep 1
+    kill "$pid" 2>/dev/null || true
+    wait "$pid" 2>/dev/null || true
+
+    echo "== low_latency $mode (scrapper on cpus $scrapperCpus, mock on cpus $mockCpus, $seconds s)"
+    if [ -f "$dir/latency.txt" ]; then
+        grep -E "^(global|shard) " "$dir/latency.txt"
+    else
+        echo "no latency dump, see $dir/scrapper.log:"
+        tail -5 "$dir/scrapper.log"
+    fi
+}
+
+run off false
+run on true
@@ -0,0 +1,74 @@
+#include "metrics.h"
+
+#include <spdlog/fmt/fmt.h>
+
+void MetricsText::family(std::string_view name, std::string_view type, std::string_view help)
+{
+    fmt::format_to(std::back_inserter(_text), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+}
+
+void MetricsText::sample(std::string_view name, double value, std::string_view labels)
+{
+    if (labels.empty())
+        fmt::format_to(std::back_inserter(_text), "{} {}\n", name, value);
+    else
+        fmt::format_to(std::back_inserter(_text), "{}{{{}}} {}\n", name, labels, value);
+}
+
+Metrics& Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::setShards(size_t shards)
+{
+    _shardsCount = std::max<size_t>(shards, 1);
+    _shards = std::make_unique<ShardMetrics[]>(_shardsCount);
+}
+
+void Metrics::recordExchangeInfoRefresh(bool succeeded, double seconds, uint64_t bytes, uint64_t wireBytes)
+{
+    if (!succeeded)
+    {
+        _exchangeInfoFailures.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _exchangeInfoRefreshes.fetch_add(1, std::memory_order_relaxed);
+    _exchangeInfoSeconds.store(seconds, std::memory_order_relaxed);
+    _exchangeInfoBytes.store(bytes, std::memory_order_relaxed);
+    _exchangeInfoWireBytes.store(wireBytes, std::memory_order_relaxed);
+}
+
+void Metrics::write(MetricsText& text) const
+{
+    auto shardCounter = [this, &text](std::string_view name, std::string_view help, std::atomic<uint64_t> ShardMetrics::* counter)
+    {
+        text.family(name, "counter", help);
+        for (size_t i = 0; i < _shardsCount; ++i)
+            text.sample(name, static_cast<double>((_shards[i].*counter).load(std::memory_order_relaxed)), fmt::format("shard=\"{}\"", i));
+    };
+    shardCounter("scrapper_messages_total", "Websocket frames received.", &ShardMetrics::messages);
+    shardCounter("scrapper_received_bytes_total", "Websocket payload bytes received.", &ShardMetrics::bytes);
+    shardCounter("scrapper_parse_errors_total", "aggTrade messages that failed to decode.", &ShardMetrics::parseErrors);
+    shardCounter("scrapper_reconnects_total", "Connections recovered by their own reconnect.", &ShardMetrics::reconnects);
+
+    text.family("scrapper_exchange_info_refreshes_total", "counter", "Successful exchangeInfo downloads.");
+    text.sample("scrapper_exchange_info_refreshes_total", static_cast<double>(_exchangeInfoRefreshes.load(std::memory_order_relaxed)));
+    text.family("scrapper_exchange_info_failures_total", "counter", "Failed exchangeInfo downloads.");
+    text.sample("scrapper_exchange_info_failures_total", static_cast<double>(_exchangeInfoFailures.load(std::memory_order_relaxed)));
+    text.family("scrapper_exchange_info_unchanged_total", "counter", "Successful exchangeInfo downloads that returned the same document, parse and update were skipped.");
+    text.sample("scrapper_exchange_info_unchanged_total", static_cast<double>(_exchangeInfoUnchanged.load(std::memory_order_relaxed)));
+    text.family("scrapper_exchange_info_refresh_seconds", "gauge", "Duration of the last successful exchangeInfo download.");
+    text.sample("scrapper_exchange_info_refresh_seconds", _exchangeInfoSeconds.load(std::memory_order_relaxed));
+    text.family("scrapper_exchange_info_bytes", "gauge", "Size of the last downloaded exchangeInfo.");
+    text.sample("scrapper_exchange_info_bytes", static_cast<double>(_exchangeInfoBytes.load(std::memory_order_relaxed)));
+    text.family("scrapper_exchange_info_wire_bytes", "gauge", "Body bytes of the last exchangeInfo download as received, compressed when server used gzip.");
+    text.sample("scrapper_exchange_info_wire_bytes", static_cast<double>(_exchangeInfoWireBytes.load(std::memory_order_relaxed)));
+    text.family("scrapper_rest_requests_total", "counter", "Finished REST requests (exchangeInfo, server time).");
+    text.sample("scrapper_rest_requests_total", static_cast<double>(_restRequests.load(std::memory_order_relaxed)));
+    text.family("scrapper_rest_reused_requests_total", "counter", "REST requests sent over a kept alive connection.");
+    text.sample("scrapper_rest_reused_requests_total", static_cast<double>(_restReusedRequests.load(std::memory_order_relaxed)));
+    text.family("scrapper_rest_connections_total", "counter", "REST connections opened (resolve, TCP connect and TLS handshake).");
+    text.sample("scrapper_rest_connections_total", static_cast<double>(_restConnections.load(std::memory_order_relaxed)));
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Counters of one io thread. Only that thread writes them (relaxed load + store, no RMW, no shared cache lines),
+// scrape reads them from another thread and sums shards up.
+struct alignas(64) ShardMetrics
+{
+    static void add(std::atomic<uint64_t>& counter, uint64_t value = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> messages = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> parseErrors = 0;
+    std::atomic<uint64_t> reconnects = 0;
+};
+
+// Prometheus text exposition format (version 0.0.4) builder.
+class MetricsText
+{
+public:
+    void family(std::string_view name, std::string_view type, std::string_view help);
+
+    // labels are written as is, e.g. shard="0"
+    void sample(std::string_view name, double value, std::string_view labels = {});
+
+    const std::string& str() const { return _text; }
+
+private:
+    std::string _text;
+};
+
+class Metrics
+{
+public:
+    static Metrics& instance();
+
+    // Called once at startup, before the metrics server and io threads start: shard counters are never reallocated after that.
+    void setShards(size_t shards);
+
+    ShardMetrics& shard(size_t shard) { return _shards[shard % _shardsCount]; }
+
+    // Thread safe, called by exchangeInfo download.
+    // wireBytes is the body as received, less than bytes when server compressed it.
+    void recordExchangeInfoRefresh(bool succeeded, double seconds, uint64_t bytes, uint64_t wireBytes);
+
+    // Thread safe, download that returned the same document (304 or equal content hash).
+    void recordExchangeInfoUnchanged() { _exchangeInfoUnchanged.fetch_add(1, std::memory_order_relaxed); }
+
+    // Thread safe, called by RestClient for every finished request and every opened connection.
+    void recordRestRequest(bool reusedConnection)
+    {
+        _restRequests.fetch_add(1, std::memory_order_relaxed);
+        if (reusedConnection)
+            _restReusedRequests.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void recordRestConnection() { _restConnections.fetch_add(1, std::memory_order_relaxed); }
+
+    // Shard counters and exchangeInfo refresh stats.
+    void write(MetricsText& text) const;
+
+private:
+    std::unique_ptr<ShardMetrics[]> _shards = std::make_unique<ShardMetrics[]>(1);
+    size_t _shardsCount = 1;
+    std::atomic<uint64_t> _exchangeInfoRefreshes = 0;
+    std::atomic<uint64_t> _exchangeInfoFailures = 0;
+    std::atomic<uint64_t> _exchangeInfoUnchanged = 0;
+    std::atomic<double> _exchangeInfoSeconds = 0.0;
+    std::atomic<uint64_t> _exchangeInfoBytes = 0;
+    std::atomic<uint64_t> _exchangeInfoWireBytes = 0;
+    std::atomic<uint64_t> _restRequests = 0;
+    std::atomic<uint64_t> _restReusedRequests = 0;
+    std::atomic<uint64_t> _restConnections = 0;
+};
@@ -0,0 +1,99 @@
+#include "metricsServer.h"
+
+#include <spdlog/spdlog.h>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+
+namespace
+{
+    // One request per connection, Prometheus opens a new one for every scrape anyway.
+    struct MetricsSession : std::enable_shared_from_this<MetricsSession>
+    {
+        MetricsSession(net::ip::tcp::socket socket, std::function<std::string()> render) : stream(std::move(socket)), render(std::move(render)) {}
+
+        void run()
+        {
+            stream.expires_after(std::chrono::seconds(10));
+            http::async_read(stream, buffer, request, [self = shared_from_this()](beast::error_code ec, std::size_t)
+            {
+                if (ec)
+                    return;
+                self->respond();
+            });
+        }
+
+        void respond()
+        {
+            response.version(request.version());
+            response.keep_alive(false);
+            if (request.method() != http::verb::get || request.target() != "/metrics")
+            {
+                response.result(http::status::not_found);
+                response.set(http::field::content_type, "text/plain");
+                response.body() = "not found\n";
+            }
+            else
+            {
+                response.result(http::status::ok);
+                response.set(http::field::content_type, "text/plain; version=0.0.4");
+                response.body() = render();
+            }
+            response.prepare_payload();
+            http::async_write(stream, response, [self = shared_from_this()](beast::error_code, std::size_t)
+            {
+                beast::error_code ignored;
+                self->stream.socket().shutdown(net::ip::tcp::socket::shutdown_send, ignored);
+            });
+        }
+
+        beast::tcp_stream stream;
+        beast::flat_buffer buffer;
+        http::request<http::empty_body> request;
+        http::response<http::string_body> response;
+        std::function<std::string()> render;
+    };
+}
+
+MetricsServer::MetricsServer(const std::string& address, unsigned short port, std::vector<Collector> collectors)
+    : _acceptor(_ioc, { net::ip::make_address(address), port })
+    , _collectors(std::move(collectors))
+{
+    spdlog::info("Serving metrics on http://{}:{}/metrics", address, port);
+    accept();
+    _thread = std::thread([this]() { _ioc.run(); });
+}
+
+MetricsServer::~MetricsServer()
+{
+    _ioc.stop();
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void MetricsServer::accept()
+{
+    _acceptor.async_accept([this](beast::error_code ec, net::ip::tcp::socket socket)
+    {
+        if (ec == net::error::operation_aborted)
+            return;
+        if (ec)
+        {
+            spdlog::error("Metrics accept: {}", ec.message());
+        }
+        else
+        {
+            std::make_shared<MetricsSession>(std::move(socket), [this]() { return render(); })->run();
+        }
+        accept();
+    });
+}
+
+std::string MetricsServer::render() const
+{
+    MetricsText text;
+    Metrics::instance().write(text);
+    for (const auto& collector : _collectors)
+        collector(text);
+    return text.str();
+}
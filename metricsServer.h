@@ -0,0 +1,42 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+
+namespace net = boost::asio;
+
+// Serves GET /metrics in Prometheus text format on its own thread, so scrapes never run on io threads.
+// Everything is collected at scrape time: shard counters from Metrics plus registered collectors (e.g. connection gauges).
+class MetricsServer
+{
+public:
+    using Collector = std::function<void(MetricsText&)>;
+
+    MetricsServer(const std::string& address, unsigned short port, std::vector<Collector> collectors);
+
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+private:
+    void accept();
+
+    std::string render() const;
+
+private:
+    net::io_context _ioc{ 1 };
+    net::ip::tcp::acceptor _acceptor;
+    std::vector<Collector> _collectors;
+    std::thread _thread;
+};
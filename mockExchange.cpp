@@ -0,0 +1,552 @@
+// scrapper_mock_exchange: local TLS stand-in for api.binance.com and stream.binance.com, for load tests on one machine.
+// One port serves both HTTPS (GET /api/v3/exchangeInfo, GET /api/v3/time) and WSS combined streams
+// (/stream?streams=<symbol>@aggTrade/..., SUBSCRIBE/UNSUBSCRIBE messages) with synthetic aggTrade frames.
+//
+//   scrapper_mock_exchange --cert cert.pem --key key.pem [--port 9443] [--threads 2] [--symbols 2000]
+//                          [--rate 10] [--drop-per-minute 0] [--handshake-delay-ms 0] [--burst-every-s 0] [--burst-size 100] [--etag 0]
+//                          [--gzip 1] [--keep-alive 1]
+//
+// --rate               aggTrade frames per second per stream
+// --drop-per-minute    probability for every connection to be dropped within a minute (0..1), reconnect testing
+// --handshake-delay-ms delay before TLS handshake of every accepted connection
+// --burst-every-s      every that many seconds each stream gets --burst-size extra frames at once
+// --etag               1 - exchangeInfo carries an ETag and If-None-Match gets 304 (Binance itself does not send one)
+// --gzip               1 - REST bodies are gzipped (fast level) when request has Accept-Encoding: gzip, 0 - always identity
+// --keep-alive         0 - every REST response closes its connection, to compare against kept alive clients
+//
+// exchangeInfo is shaped like the real one (filters, permissions, about 1 KB per symbol) and has current serverTime in every response.
+//
+// Point scrapper at it with [endpoints] in config.toml (hosts, ports and ca_file = the same cert.pem).
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace websocket = beast::websocket;
+namespace net = boost::asio;
+namespace ssl = net::ssl;
+using tcp = net::ip::tcp;
+
+namespace
+{
+    struct Settings
+    {
+        std::string address = "127.0.0.1";
+        unsigned short port = 9443;
+        std::string cert;
+        std::string key;
+        size_t threads = 2;
+        size_t symbols = 2000;
+        double ratePerStream = 10.0;
+        double dropPerMinute = 0.0;
+        size_t handshakeDelayMs = 0;
+        size_t burstEverySeconds = 0;
+        size_t burstSize = 100;
+        bool etag = false;
+        bool gzip = true;
+        bool keepAlive = true;
+    };
+
+    struct Stats
+    {
+        std::atomic<uint64_t> connections = 0;
+        std::atomic<uint64_t> frames = 0;
+        std::atomic<uint64_t> framesDropped = 0; // slow consumer, send queue full
+        std::atomic<uint64_t> connectionsDropped = 0;
+        std::atomic<uint64_t> restRequests = 0;
+        std::atomic<uint64_t> handshakes = 0; // TLS, REST and websocket
+    };
+
+    Settings g_settings;
+    Stats g_stats;
+    // Document is split around the serverTime value, which is filled in per response.
+    std::string g_exchangeInfoHead;
+    std::string g_exchangeInfoTail;
+    std::string g_exchangeInfoEtag;
+
+    constexpr auto c_tickInterval = std::chrono::milliseconds(1);
+    constexpr size_t c_maxQueuedFrames = 1 << 14;
+
+    int64_t nowMs()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Whole body at once, level 1 keeps per response cost of a multi-MB exchangeInfo at a few ms.
+    std::string gzip(std::string_view body)
+    {
+        z_stream stream{};
+        deflateInit2(&stream, 1, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        std::string out(deflateBound(&stream, static_cast<uLong>(body.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+        stream.avail_in = static_cast<uInt>(body.size());
+        stream.next_out = reinterpret_cast<Bytef*>(out.data());
+        stream.avail_out = static_cast<uInt>(out.size());
+        deflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        return out;
+    }
+
+    std::string toUpper(std::string s)
+    {
+        for (char& c : s)
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        return s;
+    }
+
+    // Majors first, so default config.toml securities exist on the mock too.
+    std::string symbolName(size_t i)
+    {
+        static const char* majors[] = { "BTCUSDT", "ETHUSDT", "BNBUSDT" };
+        if (i < std::size(majors))
+            return majors[i];
+        return fmt::format("T{:05}USDT", i);
+    }
+
+    void buildExchangeInfo(size_t symbols)
+    {
+        nlohmann::json info;
+        info["timezone"] = "UTC";
+        info["serverTime"] = 0;
+        info["rateLimits"] = nlohmann::json::array({ { { "rateLimitType", "REQUEST_WEIGHT" }, { "interval", "MINUTE" }, { "intervalNum", 1 }, { "limit", 6000 } } });
+        info["symbols"] = nlohmann::json::array();
+        for (size_t i = 0; i < symbols; ++i)
+        {
+            const std::string name = symbolName(i);
+            info["symbols"].push_back({ { "symbol", name }, { "status", "TRADING" }, { "baseAsset", name.substr(0, name.size() - 4) }, { "quoteAsset", "USDT" },
+                { "baseAssetPrecision", 8 }, { "quotePrecision", 8 }, { "orderTypes", { "LIMIT", "LIMIT_MAKER", "MARKET", "STOP_LOSS_LIMIT", "TAKE_PROFIT_LIMIT" } },
+                { "icebergAllowed", true }, { "ocoAllowed", true }, { "isSpotTradingAllowed", true }, { "isMarginTradingAllowed", false },
+                { "filters", nlohmann::json::array({
+                    { { "filterType", "PRICE_FILTER" }, { "minPrice", "0.01000000" }, { "maxPrice", "1000000.00000000" }, { "tickSize", "0.01000000" } },
+                    { { "filterType", "LOT_SIZE" }, { "minQty", "0.00001000" }, { "maxQty", "9000.00000000" }, { "stepSize", "0.00001000" } },
+                    { { "filterType", "ICEBERG_PARTS" }, { "limit", 10 } },
+                    { { "filterType", "MARKET_LOT_SIZE" }, { "minQty", "0.00000000" }, { "maxQty", "110.00000000" }, { "stepSize", "0.00000000" } },
+                    { { "filterType", "NOTIONAL" }, { "minNotional", "5.00000000" }, { "maxNotional", "9000000.00000000" } },
+                    { { "filterType", "MAX_NUM_ORDERS" }, { "maxNumOrders", 200 } } }) },
+                { "permissions", { "SPOT", "MARGIN" } } });
+        }
+
+        const std::string document = info.dump();
+        constexpr std::string_view c_serverTime = "\"serverTime\":0";
+        const size_t split = document.find(c_serverTime) + c_serverTime.size() - 1;
+        g_exchangeInfoHead = document.substr(0, split);
+        g_exchangeInfoTail = document.substr(split + 1);
+        g_exchangeInfoEtag = fmt::format("\"{:016x}\"", std::hash<std::string>{}(document));
+    }
+
+    class WsSession : public std::enable_shared_from_this<WsSession>
+    {
+    public:
+        explicit WsSession(beast::ssl_stream<beast::tcp_stream>&& stream) : _ws(std::move(stream)), _tick(_ws.get_executor()), _random(std::random_device{}()) {}
+
+        void run(http::request<http::string_body> request)
+        {
+            const std::string_view target(request.target().data(), request.target().size());
+            if (const size_t pos = target.find("streams="); pos != std::string_view::npos)
+                addStreams(target.substr(pos + 8));
+
+            beast::get_lowest_layer(_ws).expires_never();
+            _ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+            _ws.async_accept(request, [self = shared_from_this()](beast::error_code ec)
+            {
+                if (ec)
+                    return;
+                ++g_stats.connections;
+                self->_accepted = true;
+                self->_lastTick = std::chrono::steady_clock::now();
+                self->_nextBurst = self->_lastTick + std::chrono::seconds(g_settings.burstEverySeconds);
+                self->read();
+                self->tick();
+            });
+        }
+
+        ~WsSession()
+        {
+            if (_accepted)
+                --g_stats.connections;
+        }
+
+    private:
+        struct Stream
+        {
+            std::string name;   // "btcusdt@aggTrade"
+            std::string symbol; // "BTCUSDT"
+            double credit = 0.0;
+            uint64_t tradeId = 0;
+        };
+
+        void addStreams(std::string_view list)
+        {
+            while (!list.empty())
+            {
+                const size_t slash = list.find('/');
+                addStream(list.substr(0, slash));
+                list = slash == std::string_view::npos ? std::string_view{} : list.substr(slash + 1);
+            }
+        }
+
+        void addStream(std::string_view name)
+        {
+            const size_t at = name.find('@');
+            if (at == std::string_view::npos || name.empty())
+                return;
+            for (const auto& stream : _streams)
+            {
+                if (stream.name == name)
+                    return;
+            }
+            _streams.push_back({ std::string(name), toUpper(std::string(name.substr(0, at))) });
+        }
+
+        void removeStream(std::string_view name)
+        {
+            std::erase_if(_streams, [name](const Stream& stream) { return stream.name == name; });
+        }
+
+        void read()
+        {
+            _ws.async_read(_readBuffer, [self = shared_from_this()](beast::error_code ec, std::size_t)
+            {
+                if (ec)
+                    return self->close();
+                self->onControlMessage(beast::buffers_to_string(self->_readBuffer.data()));
+                self->_readBuffer.consume(self->_readBuffer.size());
+                self->read();
+            });
+        }
+
+        void onControlMessage(const std::string& text)
+        {
+            const auto message = nlohmann::json::parse(text, nullptr, false);
+            if (!message.is_object() || !message.contains("method") || !message.contains("params") || !message["params"].is_array())
+                return send(R"({"error":{"code":2,"msg":"Invalid request"}})");
+
+            const std::string method = message["method"].get<std::string>();
+            for (const auto& param : message["params"])
+            {
+                if (!param.is_string())
+                    continue;
+                if (method == "SUBSCRIBE")
+                    addStream(param.get<std::string>());
+                else if (method == "UNSUBSCRIBE")
+                    removeStream(param.get<std::string>());
+            }
+            send(fmt::format(R"({{"result":null,"id":{}}})", message.value("id", 0)));
+        }
+
+        void tick()
+        {
+            const auto now = std::chrono::steady_clock::now();
+            const double elapsed = std::chrono::duration<double>(now - _lastTick).count();
+            _lastTick = now;
+
+            if (g_settings.dropPerMinute > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(_random) < g_settings.dropPerMinute * elapsed / 60.0)
+            {
+                ++g_stats.connectionsDropped;
+                return close();
+            }
+
+            size_t burst = 0;
+            if (g_settings.burstEverySeconds > 0 && now >= _nextBurst)
+            {
+                burst = g_settings.burstSize;
+                _nextBurst = now + std::chrono::seconds(g_settings.burstEverySeconds);
+            }
+
+            const int64_t eventTime = nowMs();
+            for (auto& stream : _streams)
+            {
+                stream.credit += g_settings.ratePerStream * elapsed + burst;
+                for (; stream.credit >= 1.0; stream.credit -= 1.0)
+                    send(aggTrade(stream, eventTime));
+            }
+
+            _tick.expires_after(c_tickInterval);
+            _tick.async_wait([self = shared_from_this()](beast::error_code ec)
+            {
+                if (!ec && !self->_closed)
+                    self->tick();
+            });
+        }
+
+        std::string aggTrade(Stream& stream, int64_t eventTime)
+        {
+            const uint64_t id = ++stream.tradeId;
+            const double price = 100.0 + std::uniform_real_distribution<double>(-1.0, 1.0)(_random);
+            return fmt::format(R"({{"stream":"{}","data":{{"e":"aggTrade","E":{},"s":"{}","a":{},"p":"{:.8f}","q":"{:.8f}","f":{},"l":{},"T":{},"m":{},"M":true}}}})",
+                stream.name, eventTime, stream.symbol, id, price, 0.01 * (id % 100 + 1), id, id, eventTime, id % 2 == 0);
+        }
+
+        void send(std::string frame)
+        {
+            if (_closed)
+                return;
+            if (_queue.size() >= c_maxQueuedFrames)
+            {
+                ++g_stats.framesDropped;
+                return;
+            }
+            _queue.push_back(std::move(frame));
+            if (!_writing)
+                write();
+        }
+
+        void write()
+        {
+            _writing = true;
+            _ws.async_write(net::buffer(_queue.front()), [self = shared_from_this()](beast::error_code ec, std::size_t)
+            {
+                self->_writing = false;
+                if (ec)
+                    return self->close();
+                ++g_stats.frames;
+                self->_queue.pop_front();
+                if (!self->_queue.empty())
+                    self->write();
+            });
+        }
+
+        void close()
+        {
+            if (_closed)
+                return;
+            _closed = true;
+            _tick.cancel();
+            beast::error_code ignored;
+            beast::get_lowest_layer(_ws).socket().close(ignored); // abrupt, like a dropped connection
+        }
+
+    private:
+        websocket::stream<beast::ssl_stream<beast::tcp_stream>> _ws;
+        net::steady_timer _tick;
+        beast::flat_buffer _readBuffer;
+        std::vector<Stream> _streams;
+        std::deque<std::string> _queue;
+        std::minstd_rand _random;
+        std::chrono::steady_clock::time_point _lastTick;
+        std::chrono::steady_clock::time_point _nextBurst;
+        bool _writing = false;
+        bool _closed = false;
+        bool _accepted = false;
+    };
+
+    // TLS connection before we know whether it is a REST request or a websocket upgrade.
+    class HttpSession : public std::enable_shared_from_this<HttpSession>
+    {
+    public:
+        HttpSession(tcp::socket&& socket, ssl::context& ctx) : _stream(std::move(socket), ctx), _delay(_stream.get_executor()) {}
+
+        void run()
+        {
+            _delay.expires_after(std::chrono::milliseconds(g_settings.handshakeDelayMs));
+            _delay.async_wait([self = shared_from_this()](beast::error_code)
+            {
+                beast::get_lowest_layer(self->_stream).expires_after(std::chrono::seconds(30));
+                self->_stream.async_handshake(ssl::stream_base::server, [self](beast::error_code ec)
+                {
+                    if (ec)
+                        return;
+                    ++g_stats.handshakes;
+                    self->read();
+                });
+            });
+        }
+
+    private:
+        void read()
+        {
+            _request = {};
+            beast::get_lowest_layer(_stream).expires_after(std::chrono::seconds(30));
+            http::async_read(_stream, _buffer, _request, [self = shared_from_this()](beast::error_code ec, std::size_t)
+            {
+                if (ec)
+                    return;
+                if (websocket::is_upgrade(self->_request))
+                    return std::make_shared<WsSession>(std::move(self->_stream))->run(std::move(self->_request));
+                self->respond();
+            });
+        }
+
+        void respond()
+        {
+            ++g_stats.restRequests;
+            auto response = std::make_shared<http::response<http::string_body>>(http::status::ok, _request.version());
+            response->set(http::field::content_type, "application/json");
+            response->keep_alive(_request.keep_alive() && g_settings.keepAlive);
+            const std::string_view target(_request.target().data(), _request.target().size());
+            if (target == "/api/v3/exchangeInfo")
+            {
+                if (g_settings.etag)
+                    response->set(http::field::etag, g_exchangeInfoEtag);
+                if (g_settings.etag && _request[http::field::if_none_match] == g_exchangeInfoEtag)
+                    response->result(http::status::not_modified);
+                else
+                    response->body() = g_exchangeInfoHead + std::to_string(nowMs()) + g_exchangeInfoTail;
+            }
+            else if (target == "/api/v3/time")
+            {
+                response->body() = fmt::format(R"({{"serverTime":{}}})", nowMs());
+            }
+            else
+            {
+                response->result(http::status::not_found);
+                response->body() = R"({"code":-1,"msg":"not found"})";
+            }
+            const std::string_view acceptEncoding(_request[http::field::accept_encoding].data(), _request[http::field::accept_encoding].size());
+            if (g_settings.gzip && !response->body().empty() && acceptEncoding.find("gzip") != std::string_view::npos)
+            {
+                response->body() = gzip(response->body());
+                response->set(http::field::content_encoding, "gzip");
+            }
+            response->prepare_payload();
+            http::async_write(_stream, *response, [self = shared_from_this(), response](beast::error_code ec, std::size_t)
+            {
+                if (ec)
+                    return;
+                if (response->keep_alive())
+                    return self->read();
+                self->_stream.async_shutdown([self](beast::error_code) {});
+            });
+        }
+
+    private:
+        beast::ssl_stream<beast::tcp_stream> _stream;
+        net::steady_timer _delay;
+        beast::flat_buffer _buffer;
+        http::request<http::string_body> _request;
+    };
+
+    void accept(tcp::acceptor& acceptor, net::io_context& ioc, ssl::context& ctx)
+    {
+        acceptor.async_accept(net::make_strand(ioc), [&acceptor, &ioc, &ctx](beast::error_code ec, tcp::socket socket)
+        {
+            if (!ec)
+                std::make_shared<HttpSession>(std::move(socket), ctx)->run();
+            else if (ec == net::error::operation_aborted)
+                return;
+            accept(acceptor, ioc, ctx);
+        });
+    }
+
+    void reportStats(net::steady_timer& timer)
+    {
+        static uint64_t lastFrames = 0;
+        timer.expires_after(std::chrono::seconds(5));
+        timer.async_wait([&timer](beast::error_code ec)
+        {
+            if (ec)
+                return;
+            const uint64_t frames = g_stats.frames.load();
+            spdlog::info("{} ws connections, {:.0f} frames/s, {} frames dropped (slow consumer), {} connections dropped, {} REST requests, {} TLS handshakes",
+                g_stats.connections.load(), (frames - lastFrames) / 5.0, g_stats.framesDropped.load(), g_stats.connectionsDropped.load(), g_stats.restRequests.load(), g_stats.handshakes.load());
+            lastFrames = frames;
+            reportStats(timer);
+        });
+    }
+
+    bool parseSettings(int argc, char** argv, Settings& settings)
+    {
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const std::string_view name = argv[i];
+            const char* value = argv[i + 1];
+            if (name == "--address")
+                settings.address = value;
+            else if (name == "--port")
+                settings.port = static_cast<unsigned short>(std::atoi(value));
+            else if (name == "--cert")
+                settings.cert = value;
+            else if (name == "--key")
+                settings.key = value;
+            else if (name == "--threads")
+                settings.threads = std::max(1, std::atoi(value));
+            else if (name == "--symbols")
+                settings.symbols = std::max(1, std::atoi(value));
+            else if (name == "--rate")
+                settings.ratePerStream = std::atof(value);
+            else if (name == "--drop-per-minute")
+                settings.dropPerMinute = std::atof(value);
+            else if (name == "--handshake-delay-ms")
+                settings.handshakeDelayMs = std::max(0, std::atoi(value));
+            else if (name == "--burst-every-s")
+                settings.burstEverySeconds = std::max(0, std::atoi(value));
+            else if (name == "--burst-size")
+                settings.burstSize = std::max(0, std::atoi(value));
+            else if (name == "--etag")
+                settings.etag = std::atoi(value) != 0;
+            else if (name == "--gzip")
+                settings.gzip = std::atoi(value) != 0;
+            else if (name == "--keep-alive")
+                settings.keepAlive = std::atoi(value) != 0;
+            else
+                return false;
+        }
+        return argc % 2 == 1 && !settings.cert.empty() && !settings.key.empty();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (!parseSettings(argc, argv, g_settings))
+    {
+        spdlog::error("usage: {} --cert cert.pem --key key.pem [--address 127.0.0.1] [--port 9443] [--threads 2] [--symbols 2000] [--rate 10] "
+            "[--drop-per-minute 0] [--handshake-delay-ms 0] [--burst-every-s 0] [--burst-size 100] [--etag 0] [--gzip 1] [--keep-alive 1]", argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        buildExchangeInfo(g_settings.symbols);
+
+        ssl::context ctx{ ssl::context::tlsv12_server };
+        ctx.use_certificate_chain_file(g_settings.cert);
+        ctx.use_private_key_file(g_settings.key, ssl::context::pem);
+
+        net::io_context ioc(static_cast<int>(g_settings.threads));
+        tcp::acceptor acceptor(ioc, { net::ip::make_address(g_settings.address), g_settings.port });
+        acceptor.listen(net::socket_base::max_listen_connections);
+        accept(acceptor, ioc, ctx);
+
+        net::steady_timer statsTimer(ioc);
+        reportStats(statsTimer);
+
+        net::signal_set signals(ioc, SIGINT, SIGTERM);
+        signals.async_wait([&ioc](beast::error_code, int) { ioc.stop(); });
+
+        spdlog::info("Mock exchange on {}:{}: {} symbols, {} frames/s per stream, {} threads", g_settings.address, g_settings.port, g_settings.symbols, g_settings.ratePerStream, g_settings.threads);
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < g_settings.threads; ++i)
+            threads.emplace_back([&ioc]() { ioc.run(); });
+        ioc.run();
+        for (auto& thread : threads)
+            thread.join();
+    }
+    catch (const std::exception& e)
+    {
+        spdlog::error("Mock exchange: {}", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Bounded lock-free multi-producer single-consumer queue (Vyukov's sequence-per-cell ring).
+// Producers never block and never allocate: tryPush() returns false when the queue is full.
+template<typename T, size_t Capacity>
+class MpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "Records are copied in and out of cells");
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+public:
+    MpscQueue() : _cells(std::make_unique<Cell[]>(Capacity))
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(const T& value)
+    {
+        size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = _cells[pos & (Capacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer side only.
+    bool tryPop(T& value)
+    {
+        Cell& cell = _cells[_dequeuePos & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != _dequeuePos + 1)
+            return false; // empty, or producer has not finished writing this cell yet
+
+        value = cell.value;
+        cell.sequence.store(_dequeuePos + Capacity, std::memory_order_release);
+        ++_dequeuePos;
+        return true;
+    }
+
+    // Consumer side only. Pops up to maxItems records and passes each one to f.
+    template<typename F>
+    size_t drain(F&& f, size_t maxItems = Capacity)
+    {
+        size_t drained = 0;
+        T value;
+        while (drained < maxItems && tryPop(value))
+        {
+            f(value);
+            ++drained;
+        }
+        return drained;
+    }
+
+private:
+    std::unique_ptr<Cell[]> _cells;
+    alignas(64) std::atomic<size_t> _enqueuePos = 0;
+    alignas(64) size_t _dequeuePos = 0;
+};
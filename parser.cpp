@@ -3,52 +3,263 @@
 #include <spdlog/spdlog.h>
 #include <toml++/toml.hpp>
 
-std::vector<std::string> Parser::parseSecurities(const std::string& json_file) 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+
+namespace
 {
-    std::vector<std::string> symbols_vector;
-    try 
+    // Walks exchangeInfo once and keeps only symbols[].{symbol,status,baseAsset,quoteAsset,filters}.
+    // Keys and skipped strings stay in the lexer's reused token buffer, so the rest of the document is skipped without allocations.
+    class ExchangeInfoSax
     {
-        std::ifstream file(json_file);
-        if (!file.is_open()) 
-        {
-            spdlog::error("Failed to open file!");
-            return {};
-        }
-        json data;
-        file >> data;
-        if (data.contains("symbols") && data["symbols"].is_array()) 
+    public:
+        explicit ExchangeInfoSax(std::vector<SecurityInfo>& securities) : _securities(securities) { _scopes.reserve(16); }
+
+        bool null() { return true; }
+        bool boolean(bool) { return true; }
+        bool number_integer(json::number_integer_t) { return true; }
+        bool number_unsigned(json::number_unsigned_t) { return true; }
+        bool number_float(json::number_float_t, const json::string_t&) { return true; }
+        bool binary(json::binary_t&) { return true; }
+
+        bool string(json::string_t& value)
         {
-            for (const auto& symbol_data : data["symbols"]) 
+            if (_scopes.empty())
+                return true;
+
+            if (_scopes.back() == Scope::Symbol)
+            {
+                switch (_key)
+                {
+                case Key::Symbol: _symbol = value; break;
+                case Key::Status: _trading = value == "TRADING"; break;
+                case Key::BaseAsset: _current.baseAsset = value; break;
+                case Key::QuoteAsset: _current.quoteAsset = value; break;
+                default: break;
+                }
+            }
+            else if (_scopes.back() == Scope::Filter)
             {
-                if (symbol_data.contains("symbol") && symbol_data["symbol"].is_string()) 
+                switch (_key)
                 {
-                    auto sec = symbol_data["symbol"].get<std::string>();
-                    std::for_each(sec.begin(), sec.end(), [](char& c){ c = std::tolower(c); });
-                    symbols_vector.push_back(std::move(sec));
+                case Key::FilterType:
+                    _filterType = value == "PRICE_FILTER" ? FilterType::Price : value == "LOT_SIZE" ? FilterType::LotSize : FilterType::Other;
+                    break;
+                case Key::Min: _filterMin = std::strtod(value.c_str(), nullptr); break;
+                case Key::Max: _filterMax = std::strtod(value.c_str(), nullptr); break;
+                case Key::Step: _filterStep = std::strtod(value.c_str(), nullptr); break;
+                default: break;
                 }
             }
-        } 
-        else 
+            return true;
+        }
+
+        bool key(json::string_t& name)
         {
-            spdlog::error("JSON structure does not contain 'symbols' array or is not in the expected format");
-            return {};
+            _key = Key::Other;
+            if (_scopes.empty())
+                return true;
+
+            switch (_scopes.back())
+            {
+            case Scope::Root:
+                if (name == "symbols")
+                    _key = Key::Symbols;
+                break;
+            case Scope::Symbol:
+                if (name == "symbol")
+                    _key = Key::Symbol;
+                else if (name == "status")
+                    _key = Key::Status;
+                else if (name == "baseAsset")
+                    _key = Key::BaseAsset;
+                else if (name == "quoteAsset")
+                    _key = Key::QuoteAsset;
+                else if (name == "filters")
+                    _key = Key::Filters;
+                break;
+            case Scope::Filter:
+                if (name == "filterType")
+                    _key = Key::FilterType;
+                else if (name == "minPrice" || name == "minQty")
+                    _key = Key::Min;
+                else if (name == "maxPrice" || name == "maxQty")
+                    _key = Key::Max;
+                else if (name == "tickSize" || name == "stepSize")
+                    _key = Key::Step;
+                break;
+            default:
+                break;
+            }
+            return true;
         }
 
-    } 
-    catch (const json::parse_error& e) 
+        bool start_object(std::size_t)
+        {
+            Scope scope = Scope::Other;
+            if (_scopes.empty())
+                scope = Scope::Root;
+            else if (_scopes.back() == Scope::Symbols)
+                scope = Scope::Symbol;
+            else if (_scopes.back() == Scope::Filters)
+                scope = Scope::Filter;
+
+            if (scope == Scope::Symbol)
+            {
+                _current = SecurityInfo{};
+                _symbol.clear();
+                _trading = false;
+            }
+            else if (scope == Scope::Filter)
+            {
+                _filterType = FilterType::Other;
+                _filterMin = _filterMax = _filterStep = 0.0;
+            }
+            _scopes.push_back(scope);
+            return true;
+        }
+
+        bool end_object()
+        {
+            const Scope scope = _scopes.back();
+            _scopes.pop_back();
+            if (scope == Scope::Symbol)
+                finishSymbol();
+            else if (scope == Scope::Filter)
+                finishFilter();
+            else if (scope == Scope::Root)
+                _complete = _sawSymbols;
+            return true;
+        }
+
+        bool start_array(std::size_t)
+        {
+            Scope scope = Scope::Other;
+            if (!_scopes.empty() && _scopes.back() == Scope::Root && _key == Key::Symbols)
+            {
+                scope = Scope::Symbols;
+                _sawSymbols = true;
+            }
+            else if (!_scopes.empty() && _scopes.back() == Scope::Symbol && _key == Key::Filters)
+                scope = Scope::Filters;
+            _scopes.push_back(scope);
+            return true;
+        }
+
+        bool end_array()
+        {
+            _scopes.pop_back();
+            return true;
+        }
+
+        bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& e)
+        {
+            spdlog::error("JSON parse error at byte {}: {}", position, e.what());
+            return false;
+        }
+
+        // Document was an object with a "symbols" array.
+        bool complete() const { return _complete; }
+
+    private:
+        enum class Scope : uint8_t { Root, Symbols, Symbol, Filters, Filter, Other };
+        enum class Key : uint8_t { Other, Symbols, Symbol, Status, BaseAsset, QuoteAsset, Filters, FilterType, Min, Max, Step };
+        enum class FilterType : uint8_t { Other, Price, LotSize };
+
+        void finishSymbol()
+        {
+            if (!_trading || _symbol.empty())
+                return;
+            std::transform(_symbol.begin(), _symbol.end(), _symbol.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+            _current.symbol = SymbolTable::instance().intern(_symbol);
+            _securities.push_back(std::move(_current));
+        }
+
+        void finishFilter()
+        {
+            if (_filterType == FilterType::Price)
+            {
+                _current.minPrice = _filterMin;
+                _current.maxPrice = _filterMax;
+                _current.tickSize = _filterStep;
+            }
+            else if (_filterType == FilterType::LotSize)
+            {
+                _current.minQty = _filterMin;
+                _current.maxQty = _filterMax;
+                _current.stepSize = _filterStep;
+            }
+        }
+
+    private:
+        std::vector<SecurityInfo>& _securities;
+        std::vector<Scope> _scopes;
+        Key _key = Key::Other;
+        SecurityInfo _current;
+        // Reused for every symbol, keeps its capacity.
+        std::string _symbol;
+        bool _trading = false;
+        FilterType _filterType = FilterType::Other;
+        double _filterMin = 0.0;
+        double _filterMax = 0.0;
+        double _filterStep = 0.0;
+        bool _sawSymbols = false;
+        bool _complete = false;
+    };
+}
+
+std::vector<SecurityInfo> Parser::parseExchangeInfo(std::string_view data)
+{
+    std::vector<SecurityInfo> securities;
+    ExchangeInfoSax handler(securities);
+    if (!json::sax_parse(data.data(), data.data() + data.size(), &handler))
+        return {};
+    if (!handler.complete())
+    {
+        spdlog::error("JSON structure does not contain 'symbols' array or is not in the expected format");
+        return {};
+    }
+    return securities;
+}
+
+std::vector<SecurityInfo> Parser::parseExchangeInfoFile(const std::string& json_file)
+{
+    std::ifstream file(json_file, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) 
     {
-        spdlog::error("JSON parse error");
-        return {}; 
+        spdlog::error("Failed to open file!");
+        return {};
     }
-    catch (const std::exception& e) 
+
+    // One read of the whole file, the buffer is the only allocation proportional to its size.
+    std::string data(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(data.data(), data.size()))
     {
-        spdlog::error("Std exception: ");
-        return {}; 
+        spdlog::error("Failed to read {}", json_file);
+        return {};
     }
-    return std::move(symbols_vector);
+    return parseExchangeInfo(data);
+}
+
+std::vector<SymbolId> Parser::parseSecurities(const std::string& json_file) 
+{
+    const std::vector<SecurityInfo> securities = parseExchangeInfoFile(json_file);
+    std::vector<SymbolId> symbols;
+    symbols.reserve(securities.size());
+    for (const auto& security : securities)
+        symbols.push_back(security.symbol);
+    return symbols;
 }
 
 Config Parser::parseTomlConfig(const std::string& filePath) 
+{
+    return tryParseTomlConfig(filePath).value_or(Config{});
+}
+
+std::optional<Config> Parser::tryParseTomlConfig(const std::string& filePath) 
 {
     Config config;
     try 
@@ -83,11 +294,228 @@ Config Parser::parseTomlConfig(const std::string& filePath)
            }
 
         }
+        if (auto* networkTable = tomlData["network"].as_table(); networkTable)
+        {
+            if (auto streams = networkTable->get("streams_per_connection"); streams && streams->is_integer()) 
+            {
+                config.streamsPerConnection = streams->as_integer()->get();
+            }
+            if (auto threads = networkTable->get("io_threads"); threads && threads->is_integer()) 
+            {
+                config.ioThreads = threads->as_integer()->get();
+            }
+            if (auto pin = networkTable->get("pin_io_threads"); pin && pin->is_boolean()) 
+            {
+                config.pinIoThreads = pin->as_boolean()->get();
+            }
+            if (auto ttl = networkTable->get("dns_ttl_s"); ttl && ttl->is_integer()) 
+            {
+                config.dnsTtlSeconds = ttl->as_integer()->get();
+            }
+            if (auto inFlight = networkTable->get("max_inflight_handshakes"); inFlight && inFlight->is_integer()) 
+            {
+                config.maxInFlightHandshakes = inFlight->as_integer()->get();
+            }
+            if (auto rate = networkTable->get("connects_per_second"); rate && (rate->is_floating_point() || rate->is_integer())) 
+            {
+                config.connectsPerSecond = rate->is_integer() ? rate->as_integer()->get() : rate->as_floating_point()->get();
+            }
+        }
+        if (auto* reconnectTable = tomlData["reconnect"].as_table(); reconnectTable)
+        {
+            if (auto delay = reconnectTable->get("base_delay_ms"); delay && delay->is_integer()) 
+            {
+                config.reconnectBaseDelayMs = delay->as_integer()->get();
+            }
+            if (auto delay = reconnectTable->get("max_delay_ms"); delay && delay->is_integer()) 
+            {
+                config.reconnectMaxDelayMs = delay->as_integer()->get();
+            }
+            if (auto retries = reconnectTable->get("retries"); retries && retries->is_integer()) 
+            {
+                config.reconnectRetries = retries->as_integer()->get();
+            }
+        }
+        if (auto* latencyTable = tomlData["latency"].as_table(); latencyTable)
+        {
+            if (auto interval = latencyTable->get("dump_interval_s"); interval && interval->is_integer()) 
+            {
+                config.latencyDumpIntervalSeconds = interval->as_integer()->get();
+            }
+            if (auto file = latencyTable->get("dump_file"); file && file->is_string()) 
+            {
+                config.latencyDumpFile = file->as_string()->get();
+            }
+        }
+        if (auto* metricsTable = tomlData["metrics"].as_table(); metricsTable)
+        {
+            if (auto address = metricsTable->get("address"); address && address->is_string()) 
+            {
+                config.metricsAddress = address->as_string()->get();
+            }
+            if (auto port = metricsTable->get("port"); port && port->is_integer()) 
+            {
+                config.metricsPort = port->as_integer()->get();
+            }
+        }
+        if (auto* pipelineTable = tomlData["pipeline"].as_table(); pipelineTable)
+        {
+            if (auto workers = pipelineTable->get("workers"); workers && workers->is_integer()) 
+            {
+                config.pipelineWorkers = workers->as_integer()->get();
+            }
+            if (auto capacity = pipelineTable->get("queue_capacity"); capacity && capacity->is_integer()) 
+            {
+                config.pipelineQueueCapacity = capacity->as_integer()->get();
+            }
+            if (auto overflow = pipelineTable->get("overflow"); overflow && overflow->is_string()) 
+            {
+                config.pipelineOverflow = overflow->as_string()->get();
+            }
+            if (auto timeout = pipelineTable->get("block_timeout_us"); timeout && timeout->is_integer()) 
+            {
+                config.pipelineBlockTimeoutUs = timeout->as_integer()->get();
+            }
+        }
+        if (auto* endpointsTable = tomlData["endpoints"].as_table(); endpointsTable)
+        {
+            if (auto host = endpointsTable->get("rest_host"); host && host->is_string()) 
+            {
+                config.restHost = host->as_string()->get();
+            }
+            if (auto port = endpointsTable->get("rest_port"); port && port->is_integer()) 
+            {
+                config.restPort = std::to_string(port->as_integer()->get());
+            }
+            if (auto host = endpointsTable->get("stream_host"); host && host->is_string()) 
+            {
+                config.streamHost = host->as_string()->get();
+            }
+            if (auto port = endpointsTable->get("stream_port"); port && port->is_integer()) 
+            {
+                config.streamPort = std::to_string(port->as_integer()->get());
+            }
+            if (auto file = endpointsTable->get("ca_file"); file && file->is_string()) 
+            {
+                config.caFile = file->as_string()->get();
+            }
+        }
+        if (auto* exchangeInfoTable = tomlData["exchange_info"].as_table(); exchangeInfoTable)
+        {
+            if (auto snapshot = exchangeInfoTable->get("snapshot"); snapshot && snapshot->is_boolean()) 
+            {
+                config.exchangeInfoSnapshot = snapshot->as_boolean()->get();
+            }
+            if (auto timeout = exchangeInfoTable->get("timeout_ms"); timeout && timeout->is_integer()) 
+            {
+                config.restTimeoutMs = timeout->as_integer()->get();
+            }
+            if (auto idleTimeout = exchangeInfoTable->get("idle_timeout_ms"); idleTimeout && idleTimeout->is_integer()) 
+            {
+                config.restIdleTimeoutMs = idleTimeout->as_integer()->get();
+            }
+        }
+        if (auto* captureTable = tomlData["capture"].as_table(); captureTable)
+        {
+            if (auto file = captureTable->get("file"); file && file->is_string()) 
+            {
+                config.captureFile = file->as_string()->get();
+            }
+        }
+        if (auto* lowLatencyTable = tomlData["low_latency"].as_table(); lowLatencyTable)
+        {
+            if (auto enabled = lowLatencyTable->get("enabled"); enabled && enabled->is_boolean()) 
+            {
+                config.lowLatency.enabled = enabled->as_boolean()->get();
+            }
+            if (auto noDelay = lowLatencyTable->get("tcp_nodelay"); noDelay && noDelay->is_boolean()) 
+            {
+                config.lowLatency.tcpNoDelay = noDelay->as_boolean()->get();
+            }
+            if (auto rcvbuf = lowLatencyTable->get("rcvbuf_bytes"); rcvbuf && rcvbuf->is_integer()) 
+            {
+                config.lowLatency.receiveBufferBytes = static_cast<int>(rcvbuf->as_integer()->get());
+            }
+            if (auto busyPoll = lowLatencyTable->get("busy_poll_us"); busyPoll && busyPoll->is_integer()) 
+            {
+                config.lowLatency.busyPollUs = static_cast<int>(busyPoll->as_integer()->get());
+            }
+            if (auto loop = lowLatencyTable->get("busy_poll_io_loop"); loop && loop->is_boolean()) 
+            {
+                config.lowLatency.busyPollLoop = loop->as_boolean()->get();
+            }
+            if (auto lock = lowLatencyTable->get("mlockall"); lock && lock->is_boolean()) 
+            {
+                config.lowLatency.lockMemory = lock->as_boolean()->get();
+            }
+            if (auto prefault = lowLatencyTable->get("prefault_buffers"); prefault && prefault->is_boolean()) 
+            {
+                config.lowLatency.prefaultBuffers = prefault->as_boolean()->get();
+            }
+        }
     }
     catch (const toml::parse_error& err) 
     {
         spdlog::error("Error parsing TOML file: {} line: {} column: {}", err.description(), err.source().begin.line, err.source().begin.column);
+        return std::nullopt;
     }
 
     return config;
 }
+
+bool ConfigDiff::empty() const
+{
+    return !securities && !filter && !timer && !restEndpoint && !restTimeouts && !streamEndpoint && !streamsPerConnection
+        && !reconnectPolicy && !dnsTtl && !exchangeInfoSnapshot && requiresRestart.empty();
+}
+
+ConfigDiff ConfigDiff::all()
+{
+    ConfigDiff diff;
+    diff.securities = diff.filter = diff.timer = diff.restEndpoint = diff.restTimeouts = diff.streamEndpoint = true;
+    diff.streamsPerConnection = diff.reconnectPolicy = diff.dnsTtl = diff.exchangeInfoSnapshot = true;
+    return diff;
+}
+
+ConfigDiff Parser::diffConfigs(const Config& previous, const Config& current)
+{
+    ConfigDiff diff;
+    // Lists are short (config is written by hand), quadratic lookups are fine.
+    auto contains = [](const std::vector<std::string>& list, const std::string& value) { return std::find(list.begin(), list.end(), value) != list.end(); };
+    for (const auto& security : current.securities)
+        if (!contains(previous.securities, security) && !contains(diff.addedSecurities, security))
+            diff.addedSecurities.push_back(security);
+    for (const auto& security : previous.securities)
+        if (!contains(current.securities, security) && !contains(diff.removedSecurities, security))
+            diff.removedSecurities.push_back(security);
+
+    diff.securities = previous.securities != current.securities;
+    diff.filter = previous.filter != current.filter;
+    diff.timer = previous.timer != current.timer;
+    diff.restEndpoint = previous.restHost != current.restHost || previous.restPort != current.restPort;
+    diff.restTimeouts = previous.restTimeoutMs != current.restTimeoutMs || previous.restIdleTimeoutMs != current.restIdleTimeoutMs;
+    diff.streamEndpoint = previous.streamHost != current.streamHost || previous.streamPort != current.streamPort;
+    diff.streamsPerConnection = previous.streamsPerConnection != current.streamsPerConnection;
+    diff.reconnectPolicy = previous.reconnectBaseDelayMs != current.reconnectBaseDelayMs || previous.reconnectMaxDelayMs != current.reconnectMaxDelayMs
+        || previous.reconnectRetries != current.reconnectRetries;
+    diff.dnsTtl = previous.dnsTtlSeconds != current.dnsTtlSeconds;
+    diff.exchangeInfoSnapshot = previous.exchangeInfoSnapshot != current.exchangeInfoSnapshot;
+
+    auto startOnly = [&diff](const char* key, bool changed)
+    {
+        if (changed)
+            diff.requiresRestart.emplace_back(key);
+    };
+    startOnly("network.io_threads", previous.ioThreads != current.ioThreads);
+    startOnly("network.pin_io_threads", previous.pinIoThreads != current.pinIoThreads);
+    startOnly("network.max_inflight_handshakes", previous.maxInFlightHandshakes != current.maxInFlightHandshakes);
+    startOnly("network.connects_per_second", previous.connectsPerSecond != current.connectsPerSecond);
+    startOnly("latency", previous.latencyDumpIntervalSeconds != current.latencyDumpIntervalSeconds || previous.latencyDumpFile != current.latencyDumpFile);
+    startOnly("metrics", previous.metricsAddress != current.metricsAddress || previous.metricsPort != current.metricsPort);
+    startOnly("pipeline", previous.pipelineWorkers != current.pipelineWorkers || previous.pipelineQueueCapacity != current.pipelineQueueCapacity
+        || previous.pipelineOverflow != current.pipelineOverflow || previous.pipelineBlockTimeoutUs != current.pipelineBlockTimeoutUs);
+    startOnly("low_latency", !(previous.lowLatency == current.lowLatency));
+    startOnly("capture.file", previous.captureFile != current.captureFile);
+    startOnly("endpoints.ca_file", previous.caFile != current.caFile);
+    return diff;
+}
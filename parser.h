@@ -2,22 +2,106 @@
 
 #include <nlohmann/json.hpp>
 
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "lowLatency.h"
+#include "symbolTable.h"
+
 struct Config 
 {
     std::vector<std::string> securities;
     size_t timer = 30;
     std::string filter;
+    size_t streamsPerConnection = 1000;
+    size_t ioThreads = 1;
+    bool pinIoThreads = false;
+    size_t dnsTtlSeconds = 60;
+    size_t maxInFlightHandshakes = 8;
+    double connectsPerSecond = 5.0;
+    size_t reconnectBaseDelayMs = 100;
+    size_t reconnectMaxDelayMs = 10000;
+    size_t reconnectRetries = 8;
+    size_t latencyDumpIntervalSeconds = 60;
+    std::string latencyDumpFile = "latency.txt";
+    std::string metricsAddress = "127.0.0.1";
+    size_t metricsPort = 9100;
+    size_t pipelineWorkers = 0;
+    size_t pipelineQueueCapacity = 4096;
+    std::string pipelineOverflow = "block";
+    size_t pipelineBlockTimeoutUs = 0;
+    LowLatencyProfile lowLatency;
+    std::string captureFile;
+    bool exchangeInfoSnapshot = true; // write every changed exchangeInfo to disk in the background
+    size_t restTimeoutMs = 15000; // whole REST request: connect, send and read body
+    size_t restIdleTimeoutMs = 5000; // longest silence of the server within a REST request
+    // Live exchange by default, point them to scrapper_mock_exchange for load tests.
+    std::string restHost = "api.binance.com";
+    std::string restPort = "443";
+    std::string streamHost = "stream.binance.com";
+    std::string streamPort = "443";
+    std::string caFile; // extra trusted certificates, e.g. the mock exchange's self-signed one
 };
 
+// What differs between two parsed configs, see Parser::diffConfigs().
+struct ConfigDiff
+{
+    std::vector<std::string> addedSecurities;
+    std::vector<std::string> removedSecurities;
+    bool securities = false; // list changed in any way, order included
+    bool filter = false;
+    bool timer = false;
+    bool restEndpoint = false;
+    bool restTimeouts = false;
+    bool streamEndpoint = false;
+    bool streamsPerConnection = false;
+    bool reconnectPolicy = false;
+    bool dnsTtl = false;
+    bool exchangeInfoSnapshot = false;
+    // Keys of changed settings that are read only on start (io threads, pipeline, capture, ...).
+    std::vector<std::string> requiresRestart;
+
+    bool empty() const;
+
+    // Every setting counts as changed, used to apply the first config.
+    static ConfigDiff all();
+};
+
+
+// Trading rules of one symbol from exchangeInfo, only the fields the service uses (PRICE_FILTER and LOT_SIZE).
+struct SecurityInfo
+{
+    SymbolId symbol = c_invalidSymbolId;
+    std::string baseAsset;
+    std::string quoteAsset;
+    double minPrice = 0.0;
+    double maxPrice = 0.0;
+    double tickSize = 0.0;
+    double minQty = 0.0;
+    double maxQty = 0.0;
+    double stepSize = 0.0;
+};
 
 using json = nlohmann::json;
 class Parser 
 {
 public:
-    static std::vector<std::string> parseSecurities(const std::string& json_file); 
+    // Lowercase symbols with status TRADING interned into SymbolTable, in exchangeInfo order.
+    static std::vector<SymbolId> parseSecurities(const std::string& json_file); 
+
+    // One streaming (SAX) pass over exchangeInfo, no DOM is built and skipped values are not stored. TRADING symbols only, empty on malformed input.
+    static std::vector<SecurityInfo> parseExchangeInfo(std::string_view json);
+
+    static std::vector<SecurityInfo> parseExchangeInfoFile(const std::string& json_file);
+
+    // Defaults when file is missing or malformed.
     static Config parseTomlConfig(const std::string& filePath); 
+
+    // Nullopt when file is missing or malformed, so a half written file never replaces a working config.
+    static std::optional<Config> tryParseTomlConfig(const std::string& filePath);
+
+    static ConfigDiff diffConfigs(const Config& previous, const Config& current);
 };
 
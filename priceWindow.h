@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+// Last longWindow prices in a fixed ring allocated once, with running sums of the newest shortWindow prices and of all of them.
+// push() subtracts the prices leaving each window instead of summing the windows again, so cost per trade does not depend on window length.
+// Add/subtract rounding would slowly accumulate, so every longWindow pushes both sums are recomputed from the ring (amortized O(1)).
+class PriceWindow
+{
+public:
+    PriceWindow(size_t shortWindow, size_t longWindow)
+        : _capacity(std::max<size_t>(longWindow, 1))
+        , _shortWindow(std::clamp<size_t>(shortWindow, 1, _capacity))
+        , _prices(std::make_unique<double[]>(_capacity))
+    {
+    }
+
+    void push(double price)
+    {
+        // Both leaving prices are read before the slot of the oldest one is overwritten.
+        if (_size >= _shortWindow)
+            _shortSum -= _prices[_head >= _shortWindow ? _head - _shortWindow : _head + _capacity - _shortWindow];
+        if (_size == _capacity)
+            _longSum -= _prices[_head];
+        else
+            ++_size;
+
+        _prices[_head] = price;
+        _shortSum += price;
+        _longSum += price;
+        _head = _head + 1 == _capacity ? 0 : _head + 1;
+        if (++_pushesSinceResum == _capacity)
+            resum();
+    }
+
+    // Long window is filled, both averages are defined.
+    bool full() const { return _size == _capacity; }
+
+    double shortAverage() const { return _shortSum / static_cast<double>(std::min(_size, _shortWindow)); }
+
+    double longAverage() const { return _longSum / static_cast<double>(_size); }
+
+private:
+    void resum()
+    {
+        _pushesSinceResum = 0;
+        _shortSum = 0.0;
+        _longSum = 0.0;
+        // Newest first, so the short window is a prefix of the walk.
+        size_t index = _head;
+        for (size_t i = 0; i < _size; ++i)
+        {
+            index = index == 0 ? _capacity - 1 : index - 1;
+            if (i < _shortWindow)
+                _shortSum += _prices[index];
+            _longSum += _prices[index];
+        }
+    }
+
+private:
+    const size_t _capacity;
+    const size_t _shortWindow;
+    std::unique_ptr<double[]> _prices;
+    size_t _head = 0; // slot of the next price
+    size_t _size = 0;
+    size_t _pushesSinceResum = 0;
+    double _shortSum = 0.0;
+    double _longSum = 0.0;
+};
@@ -0,0 +1,128 @@
+// scrapper_replay: feeds a capture written by FeedCapture ([capture] in config.toml) through the same
+// decode + TradingAlgorithm path the websocket client uses, and reports throughput.
+//
+//   scrapper_replay <capture file> [--paced] [--decode-only] [--loops N] [--verbose]
+//
+// --paced       keep recorded gaps between frames instead of running at maximum speed, frames of all io threads merged by receive time
+// --decode-only stop after AggTradeDecoder, do not run strategies
+// --loops N     replay the file N times (strategy state is kept between loops)
+// --verbose     keep per trade strategy logging, muted by default so it does not dominate the measurement
+
+#include "feedCapture.h"
+#include "aggTradeDecoder.h"
+#include "tradingSystem.h"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        std::string path;
+        bool paced = false;
+        bool decodeOnly = false;
+        size_t loops = 1;
+        bool verbose = false;
+    };
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::strcmp(argv[i], "--paced") == 0)
+                options.paced = true;
+            else if (std::strcmp(argv[i], "--decode-only") == 0)
+                options.decodeOnly = true;
+            else if (std::strcmp(argv[i], "--verbose") == 0)
+                options.verbose = true;
+            else if (std::strcmp(argv[i], "--loops") == 0 && i + 1 < argc)
+                options.loops = std::max(1, std::atoi(argv[++i]));
+            else if (options.path.empty() && argv[i][0] != '-')
+                options.path = argv[i];
+            else
+                return false;
+        }
+        return !options.path.empty();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        spdlog::error("usage: {} <capture file> [--paced] [--decode-only] [--loops N] [--verbose]", argv[0]);
+        return 1;
+    }
+
+    CaptureReader reader(options.path);
+    if (!reader.isValid())
+        return 1;
+
+    std::vector<std::unique_ptr<TradingAlgorithm>> algorithms;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t parseErrors = 0;
+    bool truncated = false;
+
+    if (!options.verbose)
+        spdlog::set_level(spdlog::level::warn);
+    const auto started = std::chrono::steady_clock::now();
+    for (size_t loop = 0; loop < options.loops; ++loop)
+    {
+        int64_t firstRecordedNs = -1;
+        std::chrono::steady_clock::time_point loopStarted;
+        auto replay = [&](int64_t receivedNs, uint32_t symbolId, std::string_view frame)
+        {
+            if (options.paced)
+            {
+                // Frames come in time order, the first one is the earliest of the capture.
+                if (firstRecordedNs < 0)
+                {
+                    firstRecordedNs = receivedNs;
+                    loopStarted = std::chrono::steady_clock::now();
+                }
+                std::this_thread::sleep_until(loopStarted + std::chrono::nanoseconds(receivedNs - firstRecordedNs));
+            }
+
+            ++messages;
+            bytes += frame.size();
+
+            std::string_view symbol;
+            std::string_view data;
+            AggTrade trade;
+            if (!AggTradeDecoder::splitCombinedFrame(frame, symbol, data) || !AggTradeDecoder::decode(data, trade))
+            {
+                ++parseErrors;
+                return;
+            }
+            if (options.decodeOnly)
+                return;
+
+            if (symbolId >= algorithms.size())
+                algorithms.resize(symbolId + 1);
+            if (!algorithms[symbolId])
+                algorithms[symbolId] = std::make_unique<TradingAlgorithm>();
+            algorithms[symbolId]->execute(trade);
+        };
+        // File order is per io thread only, pacing needs one timeline.
+        truncated |= !(options.paced ? reader.forEachInTimeOrder(replay) : reader.forEach(replay));
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    spdlog::set_level(spdlog::level::info);
+
+    if (truncated)
+        spdlog::warn("{} ends with a partial record, it was ignored", options.path);
+    spdlog::info("Replayed {} frames ({:.1f} MB) of {} symbols in {:.3f} s{}: {:.0f} msg/s, {:.1f} MB/s, {} parse errors",
+        messages, bytes / (1024.0 * 1024.0), reader.symbols().size(), elapsed.count(), options.paced ? " (paced)" : "",
+        messages / elapsed.count(), bytes / (1024.0 * 1024.0) / elapsed.count(), parseErrors);
+    return 0;
+}
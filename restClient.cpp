@@ -0,0 +1,238 @@
+#include "restClient.h"
+#include "dnsCache.h"
+#include "tlsSessionCache.h"
+#include "metrics.h"
+
+#include <boost/beast/version.hpp>
+#include <boost/beast/zlib/error.hpp>
+#include <spdlog/spdlog.h>
+
+RestClient::RestClient(net::io_context& ioc, ssl::context& ctx) : _ioc(ioc), _ctx(ctx), _deadline(ioc)
+{
+}
+
+void RestClient::setEndpoint(const std::string& host, const std::string& port)
+{
+    if (host == _host && port == _port)
+        return;
+
+    close();
+    _host = host;
+    _port = port;
+}
+
+void RestClient::setTimeouts(std::chrono::milliseconds total, std::chrono::milliseconds idle)
+{
+    _totalTimeout = total;
+    _idleTimeout = idle;
+}
+
+void RestClient::get(const std::string& target, const http::fields& headers, Handler handler)
+{
+    _request = { http::verb::get, target, 11 };
+    _request.set(http::field::host, _host);
+    _request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    _request.set(http::field::accept_encoding, "gzip");
+    _request.keep_alive(true);
+    for (const auto& field : headers)
+        _request.set(field.name_string(), field.value());
+
+    _handler = std::move(handler);
+    _response = {};
+    _retried = false;
+    _abort = {};
+    _deadline.expires_after(_totalTimeout);
+    _deadline.async_wait([this, requestId = ++_requestId](beast::error_code ec)
+    {
+        // Timer of a request that already finished may still fire, id tells them apart.
+        if (!ec && requestId == _requestId && busy())
+            onDeadline();
+    });
+
+    _reused = _stream.has_value();
+    if (_reused)
+        return write();
+
+    connect();
+}
+
+void RestClient::cancel()
+{
+    if (!busy() || _abort)
+        return;
+
+    _abort = net::error::operation_aborted;
+    // Pending operation completes with operation_aborted, stream itself is released once it did.
+    if (_stream)
+        beast::get_lowest_layer(*_stream).close();
+}
+
+void RestClient::onDeadline()
+{
+    const std::string_view target(_request.target().data(), _request.target().size());
+    spdlog::warn("RestClient: GET {} from {}:{} did not finish within {} ms, aborting", target, _host, _port, _totalTimeout.count());
+    cancel();
+    _abort = beast::error::timeout;
+}
+
+void RestClient::close()
+{
+    if (!_stream)
+        return;
+
+    // No TLS close_notify round trip, server drops idle keep-alive connections the same way.
+    beast::error_code ec;
+    beast::get_lowest_layer(*_stream).socket().close(ec);
+    _stream.reset();
+}
+
+bool RestClient::prepareOperation()
+{
+    if (_abort)
+        return false;
+
+    beast::get_lowest_layer(*_stream).expires_after(_idleTimeout);
+    return true;
+}
+
+void RestClient::connect()
+{
+    _reused = false;
+    _stream.emplace(_ioc, _ctx);
+    _buffer.clear();
+    DnsCache::instance().asyncResolve(_host, _port, _stream->get_executor(),
+    [this](const beast::error_code& ec, const net::ip::tcp::resolver::results_type& results)
+    {
+        if (ec)
+            return finish(ec, "resolve");
+        if (!prepareOperation())
+            return finish({}, "resolve");
+
+        beast::get_lowest_layer(*_stream).async_connect(results, [this](beast::error_code ec, net::ip::tcp::endpoint)
+        {
+            if (ec)
+                return finish(ec, "connect");
+            if (!prepareOperation())
+                return finish({}, "connect");
+
+            TlsSessionCache::instance().prepare(_stream->native_handle(), _host, _port);
+            _stream->async_handshake(ssl::stream_base::client, [this](beast::error_code ec)
+            {
+                if (ec)
+                    return finish(ec, "handshake");
+
+                TlsSessionCache::instance().onHandshake(_stream->native_handle());
+                ++_connectionsOpened;
+                Metrics::instance().recordRestConnection();
+                write();
+            });
+        });
+    });
+}
+
+void RestClient::write()
+{
+    _response.reusedConnection = _reused;
+    if (!prepareOperation())
+        return finish({}, "write");
+
+    http::async_write(*_stream, _request, [this](beast::error_code ec, std::size_t)
+    {
+        if (ec)
+            return onError(ec, "write");
+
+        readHeader();
+    });
+}
+
+void RestClient::readHeader()
+{
+    if (!prepareOperation())
+        return finish({}, "read header");
+
+    _parser.emplace();
+    _parser->body_limit(c_bodyLimit);
+    http::async_read_header(*_stream, _buffer, *_parser, [this](beast::error_code ec, std::size_t)
+    {
+        if (ec)
+            return onError(ec, "read header");
+
+        const auto encoding = _parser->get()[http::field::content_encoding];
+        _gzip = encoding == "gzip" || encoding == "x-gzip";
+        if (!_gzip && !encoding.empty() && encoding != "identity")
+            return finish(http::error::bad_field, "content encoding");
+
+        _inflater.reset();
+        _response.body.reserve(_lastBodySize);
+        readBody();
+    });
+}
+
+void RestClient::readBody()
+{
+    if (_parser->is_done())
+    {
+        if (_gzip && !_inflater.finished() && _response.wireBytes > 0)
+            return finish(beast::zlib::error::general, "inflate");
+
+        if (!_parser->keep_alive())
+            close();
+        _response.header = std::move(_parser->get().base());
+        _lastBodySize = std::max(_lastBodySize, _response.body.size());
+        return finish({}, "");
+    }
+
+    if (!prepareOperation())
+        return finish({}, "read body");
+
+    // Body lands in _chunk and is consumed (appended or inflated) before the next read, whatever its size only one chunk is in flight.
+    _parser->get().body().data = _chunk.data();
+    _parser->get().body().size = _chunk.size();
+    http::async_read_some(*_stream, _buffer, *_parser, [this](beast::error_code ec, std::size_t)
+    {
+        if (ec == http::error::need_buffer)
+            ec = {};
+        if (ec)
+            return finish(ec, "read body");
+
+        const size_t received = _chunk.size() - _parser->get().body().size;
+        _response.wireBytes += received;
+        if (!_gzip)
+            _response.body.append(_chunk.data(), received);
+        else if (!_inflater.inflate(_chunk.data(), received, _response.body, c_bodyLimit))
+            return finish(beast::zlib::error::general, "inflate");
+
+        readBody();
+    });
+}
+
+void RestClient::onError(beast::error_code ec, const char* stage)
+{
+    // Server may close an idle keep-alive connection any time, nothing of the response was received yet so GET is simply sent again.
+    if (_response.reusedConnection && !_retried && !_abort)
+    {
+        spdlog::debug("RestClient: kept alive connection to {}:{} is gone ({}: {}), reconnecting", _host, _port, stage, ec.message());
+        close();
+        _retried = true;
+        return connect();
+    }
+
+    finish(ec, stage);
+}
+
+void RestClient::finish(beast::error_code ec, const char* stage)
+{
+    if (_abort)
+        ec = _abort;
+    if (ec)
+        close();
+
+    _deadline.cancel();
+    _parser.reset();
+    _response.stage = stage;
+    Metrics::instance().recordRestRequest(_response.reusedConnection);
+    // Handler may start the next request right away.
+    Handler handler = std::move(_handler);
+    _handler = nullptr;
+    handler(ec, _response);
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/ssl.hpp>
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gzipInflater.h"
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+namespace ssl = net::ssl;
+
+// Long lived HTTPS client for REST endpoints of one host, e.g. /api/v3/exchangeInfo and /api/v3/time of api.binance.com.
+// Connection (cached DNS, TCP, TLS with session resumption) is opened by the first request and kept alive for the next ones,
+// a request that finds the connection closed by server in the meantime is retried once on a new one.
+// Asks for gzip and inflates body chunk by chunk as it arrives. Every step is asynchronous, so the client shares its io_context with other work.
+// Request is bounded by a total deadline and by an idle timeout between two socket reads or writes.
+// One request at a time, all calls on the thread running io_context.
+class RestClient
+{
+public:
+    struct Response
+    {
+        http::response_header<> header;
+        std::string body;               // inflated
+        uint64_t wireBytes = 0;         // body bytes as received, compressed ones when server used gzip
+        bool reusedConnection = false;
+        const char* stage = "";         // step that failed, when handler gets an error
+    };
+
+    using Handler = std::function<void(beast::error_code, Response&)>;
+
+    RestClient(net::io_context& ioc, ssl::context& ctx);
+
+    // Call while not busy(), open connection to another endpoint is closed.
+    void setEndpoint(const std::string& host, const std::string& port);
+
+    // total - whole request including connect, idle - longest wait for any single socket operation. Used from the next request on.
+    void setTimeouts(std::chrono::milliseconds total, std::chrono::milliseconds idle);
+
+    // GET target, headers are added to the request (e.g. If-None-Match). Handler is called exactly once,
+    // with beast::error::timeout when a timeout expired and net::error::operation_aborted after cancel().
+    void get(const std::string& target, const http::fields& headers, Handler handler);
+
+    // Aborts request in flight, its connection is dropped. No-op when idle.
+    void cancel();
+
+    bool busy() const { return static_cast<bool>(_handler); }
+
+    uint64_t connectionsOpened() const { return _connectionsOpened; }
+
+private:
+    using Stream = beast::ssl_stream<beast::tcp_stream>;
+
+    void connect();
+
+    void write();
+
+    void readHeader();
+
+    void readBody();
+
+    // Arms idle timeout of the next socket operation, false when request was aborted meanwhile.
+    bool prepareOperation();
+
+    void onDeadline();
+
+    void close();
+
+    void onError(beast::error_code ec, const char* stage);
+
+    void finish(beast::error_code ec, const char* stage);
+
+private:
+    // Limit of inflated and of received body.
+    static constexpr size_t c_bodyLimit = 64 * 1024 * 1024;
+    static constexpr size_t c_chunkSize = 64 * 1024;
+
+    using Parser = http::response_parser<http::buffer_body>;
+
+    net::io_context& _ioc;
+    ssl::context& _ctx;
+    std::string _host;
+    std::string _port;
+
+    std::optional<Stream> _stream;
+    beast::flat_buffer _buffer;
+    std::vector<char> _chunk = std::vector<char>(c_chunkSize);
+    std::optional<Parser> _parser;
+    GzipInflater _inflater;
+    bool _gzip = false;
+
+    http::request<http::empty_body> _request;
+    Response _response;
+    Handler _handler;
+    net::steady_timer _deadline;
+    std::chrono::milliseconds _totalTimeout{ 15000 };
+    std::chrono::milliseconds _idleTimeout{ 5000 };
+    // Why request in flight is being aborted (timeout or operation_aborted), empty otherwise.
+    beast::error_code _abort;
+    uint64_t _requestId = 0;
+    bool _reused = false;
+    bool _retried = false;
+    size_t _lastBodySize = 0;
+    uint64_t _connectionsOpened = 0;
+};
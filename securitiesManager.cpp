@@ -1,103 +1,99 @@
 #include "securitiesManager.h"
 #include "Event.h"
+#include "latencyStats.h"
+#include "metrics.h"
+
+#include <nlohmann/json.hpp>
 
 void BinanceSession::run() 
 {
-    resolver_.async_resolve(host_, port_,
-    [this](beast::error_code ec, net::ip::tcp::resolver::results_type results) 
+    _startedAt = std::chrono::steady_clock::now();
+    // Server that supports validators answers 304 without a body when nothing changed.
+    http::fields headers;
+    if (const std::string etag = _store.etag(); !etag.empty())
+        headers.set(http::field::if_none_match, etag);
+    if (const std::string lastModified = _store.lastModified(); !lastModified.empty())
+        headers.set(http::field::if_modified_since, lastModified);
+    _client.get("/api/v3/exchangeInfo", headers, [this](beast::error_code ec, RestClient::Response& response)
     {
-        if (ec) 
-            return fail(ec, "resolve");
- 
-        onResolve(ec, results);
+        onResponse(ec, response);
     });
 }
 
-void BinanceSession::onResolve(beast::error_code ec, net::ip::tcp::resolver::results_type results) 
+void BinanceSession::onResponse(beast::error_code ec, RestClient::Response& response)
 {
     if (ec)
-        return fail(ec, "resolve");
+        return fail(ec, response.stage);
 
-    boost::asio::async_connect(stream_.next_layer(), results, [this](beast::error_code ec, net::ip::tcp::endpoint) 
+    if (response.header.result() == http::status::not_modified)
     {
-        onConnect(ec);
-    });
+        _store.notModified();
+        return succeed(0, 0, response.reusedConnection);
+    }
+
+    if (response.header.result() != http::status::ok)
+    {
+        spdlog::error("HTTP request failed: {}", response.header.result_int());
+        return fail(ec, "http status");
+    }
+
+    const uint64_t bytes = response.body.size();
+    const uint64_t wireBytes = response.wireBytes;
+    const bool reused = response.reusedConnection;
+    _store.publish(std::move(response.body), std::string(response.header[http::field::etag]), std::string(response.header[http::field::last_modified]));
+    succeed(bytes, wireBytes, reused);
 }
 
-void BinanceSession::onConnect(beast::error_code ec) 
+void BinanceSession::succeed(uint64_t bytes, uint64_t wireBytes, bool reusedConnection)
 {
-    if (ec)
-        return fail(ec, "connect");
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _startedAt;
+    spdlog::info("exchangeInfo downloaded in {:.1f} ms: {} bytes, {} on the wire, {} connection", elapsed.count() * 1000.0, bytes, wireBytes, reusedConnection ? "kept alive" : "new");
+    Metrics::instance().recordExchangeInfoRefresh(true, elapsed.count(), bytes, wireBytes);
+    if(_eventToNotify)
+        _eventToNotify->endEvent();
+}
 
-    stream_.async_handshake(ssl::stream_base::client, [this](beast::error_code ec) 
-    {
-        onHandshake(ec);
-    });
+void BinanceSession::fail(beast::error_code ec, char const* what) 
+{
+    spdlog::error("BinanceSession error: {}: {}. Program will try again in given timeout(see config.toml)", what, ec.message());
+    Metrics::instance().recordExchangeInfoRefresh(false, 0.0, 0, 0);
+    // notify even in case of failure.
+    if(_eventToNotify)
+        _eventToNotify->endEvent();
 }
 
-void BinanceSession::onHandshake(beast::error_code ec) 
+void ServerTimeSession::run()
 {
-    if (ec)
-        return fail(ec, "handshake");
+    _samplesDone = 0;
+    sendRequest();
+}
 
-    _req.set(http::field::host, host_);
-    _req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
-    http::async_write(stream_, _req, [this](beast::error_code ec, std::size_t bytes_transferred) 
+void ServerTimeSession::sendRequest()
+{
+    _sentNs = systemNowNs();
+    _client.get("/api/v3/time", {}, [this](beast::error_code ec, RestClient::Response& response)
     {
-        onWrite(ec, bytes_transferred);
+        onResponse(ec, response);
     });
 }
 
-void BinanceSession::onWrite(beast::error_code ec, std::size_t bytes_transferred) 
+void ServerTimeSession::onResponse(beast::error_code ec, RestClient::Response& response)
 {
+    const int64_t receivedNs = systemNowNs();
     if (ec)
-        return fail(ec, "write");
-
-    http::response_parser<http::file_body> parser;
-    constexpr size_t c_exchangeInfoResponseLimit = 1024 * 1024 * 64;
-    parser.body_limit(c_exchangeInfoResponseLimit);
-    parser.get().body().open(_filename.c_str(), beast::file_mode::write, ec);
-    if (ec) 
-    {
-        spdlog::error("Error during openning of a file: {}", _filename);
-        stream_.shutdown(ec); 
-        return fail(ec, "file openning");
-    }
-
-    beast::flat_buffer buffer;
-    while (!parser.is_done()) 
     {
-        http::read(stream_, buffer, parser, ec);
-        if(ec && ec != net::error::eof) 
-        {
-            spdlog::error("HTTP read error: {}", ec.message());
-            stream_.shutdown(ec);
-            if (ec) 
-                spdlog::error("Stream shutdown error: {}", ec.message());
-            return fail(ec, "stream shutdown");
-        }
+        spdlog::error("ServerTimeSession error: {}: {}. Exchange clock offset is sampled again on next timer tick", response.stage, ec.message());
+        return;
     }
 
-    if(parser.get().result() != http::status::ok)
+    const auto body = nlohmann::json::parse(response.body, nullptr, false);
+    if (response.header.result() != http::status::ok || !body.is_object() || !body.contains("serverTime") || !body["serverTime"].is_number_integer())
     {
-        spdlog::error("HTTP request failed: ");
-        stream_.shutdown(ec); 
+        spdlog::error("ServerTimeSession: unexpected response {}: {}", response.header.result_int(), response.body);
         return;
     }
 
-    // eof error is expected
-    ec = ec == net::error::eof ? beast::error_code{} : ec;
-
-    stream_.shutdown(ec); 
-
-    if(_eventToNotify)
-        _eventToNotify->endEvent();
-}
-
-void BinanceSession::fail(beast::error_code ec, char const* what) 
-{
-    spdlog::error("BinanceSession error: {}: {}. Program will try again in given timeout(see config.toml)", what, ec.message());
-    // notify even in case of failure.
-    if(_eventToNotify)
-        _eventToNotify->endEvent();
+    ClockOffsetEstimator::instance().addSample(body["serverTime"].get<int64_t>(), _sentNs, receivedNs);
+    if (++_samplesDone < c_samples)
+        sendRequest();
 }
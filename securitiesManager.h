@@ -33,6 +33,9 @@
 
 #include <spdlog/spdlog.h>
 
+#include "exchangeInfoStore.h"
+#include "restClient.h"
+
 struct Event;
 
 namespace beast = boost::beast;
@@ -42,42 +45,55 @@ namespace ssl = net::ssl;
 namespace websocket = boost::beast::websocket;
 using tcp = net::ip::tcp;
 
+// GET /api/v3/exchangeInfo over kept alive RestClient, body is kept in memory and handed to ExchangeInfoStore. Conditional request when store has validators.
 class BinanceSession {
 public:
-    BinanceSession(boost::asio::io_context& ioc, boost::asio::ssl::context& ctx, const std::string& host, const std::string& port, const std::string& filename, Event* eventPtr)
-        : resolver_(ioc)
-        , stream_(ioc, ctx)
-        , host_(host)
-        , port_(port)
-        , _filename(filename)
+    BinanceSession(RestClient& client, ExchangeInfoStore& store, Event* eventPtr)
+        : _client(client)
+        , _store(store)
         , _eventToNotify(eventPtr)
     {
-        if(_filename.empty())
-            spdlog::info("WARNING: filepath to save securities symbols is empty.");
     }
 
     void run(); 
     
 private:
-    void onResolve(beast::error_code ec, boost::asio::ip::tcp::resolver::results_type results); 
-    
-    void onConnect(boost::beast::error_code ec);
-    
-    void onHandshake(boost::beast::error_code ec); 
-    
-    void onWrite(boost::beast::error_code ec, std::size_t bytes_transferred); 
+    void onResponse(beast::error_code ec, RestClient::Response& response);
 
-    void fail(boost::beast::error_code ec, char const* what); 
+    void succeed(uint64_t bytes, uint64_t wireBytes, bool reusedConnection);
+
+    void fail(beast::error_code ec, char const* what); 
 
 private:
-    http::request<http::string_body> _req{ http::verb::get, "/api/v3/exchangeInfo", 11 };
-    net::ip::tcp::resolver resolver_;
-    beast::ssl_stream<net::ip::tcp::socket> stream_;
-    std::string host_;
-    std::string port_;
-    std::string _filename = "exchange_info.json";
+    RestClient& _client;
+    ExchangeInfoStore& _store;
     Event* _eventToNotify = nullptr;
+    std::chrono::steady_clock::time_point _startedAt;
 };
 
+// Samples exchange clock with a few GET /api/v3/time over kept alive RestClient, feeds ClockOffsetEstimator.
+// Offset is used to turn aggTrade event time "E" into exchange->receive latency.
+class ServerTimeSession {
+public:
+    explicit ServerTimeSession(RestClient& client)
+        : _client(client)
+    {
+    }
+
+    void run();
+
+private:
+    void sendRequest();
+
+    void onResponse(beast::error_code ec, RestClient::Response& response);
+
+private:
+    // Best (shortest round trip) sample of these is kept, first one also pays for connect and slow start.
+    static constexpr size_t c_samples = 4;
+
+    RestClient& _client;
+    int64_t _sentNs = 0;
+    size_t _samplesDone = 0;
+};
 
 //class OtherSession {}
\ No newline at end of file
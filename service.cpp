@@ -25,12 +25,20 @@
 
 #include "webSocketConnection.h"
 #include "securitiesManager.h"
+#include "dnsCache.h"
 
 void Service::run()
 {
     try
     {
-        updateConfig();
+        loadConfig();
+        if(!_serviceConfiguration.caFile.empty())
+        {
+            _downloadedEvent.addTrustedCertificates(_serviceConfiguration.caFile);
+            _connectionsManager.addTrustedCertificates(_serviceConfiguration.caFile);
+        }
+        startMetricsServer();
+        startConfigWatcher();
         auto downloadSecurities = std::async(std::launch::async, [this]()
         {
             try
@@ -56,56 +64,170 @@ void Service::update()
 {
     while(1)
     {
+        _downloadedEvent.waitForEvent(); // sleeps until exchangeinfo download finished (or failed), config.toml changed or latency dump is due
         if(_downloadedEvent.isDone())
         {
-            updateSymbols();
-            _connectionsManager.update(getSymbols());
+            spdlog::info("Update thread woke up {} us after event", std::chrono::duration_cast<std::chrono::microseconds>(_downloadedEvent.sinceEnded()).count());
+            // Restart before the work, so a download or config change that happens meanwhile is not lost.
             _downloadedEvent.restartEvent();
+            if(_configChanged.exchange(false))
+                reloadConfig();
+            _connectionsManager.dumpLatencyIfDue();
+            if(updateSymbols())
+                _connectionsManager.update(getSymbols());
+            else
+                _connectionsManager.reconnectFailed();
+            _connectionsManager.logReconnectStats();
         }
     }
 }
 
-void Service::updateConfig()
+void Service::loadConfig()
 {
-    if(!isFileExists("config.toml"))
+    if(!isFileExists(c_configFile))
     {
         spdlog::info("Config file is not available, use default config.");
     }
 
-    _serviceConfiguration = Parser::parseTomlConfig("config.toml");
-    _downloadedEvent.setTimeOut(_serviceConfiguration.timer);
-    spdlog::info("Config: timer: {}, filter: {}", _serviceConfiguration.timer, _serviceConfiguration.filter);
+    _serviceConfiguration = Parser::parseTomlConfig(c_configFile);
+    // Read once, before the first update() starts io threads.
+    _connectionsManager.setIoThreads(_serviceConfiguration.ioThreads, _serviceConfiguration.pinIoThreads);
+    // Sized here, before the metrics server thread reads the shard counters.
+    Metrics::instance().setShards(_serviceConfiguration.ioThreads);
+    _connectionsManager.setConnectionRamp(_serviceConfiguration.maxInFlightHandshakes, _serviceConfiguration.connectsPerSecond);
+    _connectionsManager.setCaptureFile(_serviceConfiguration.captureFile);
+    _connectionsManager.setLowLatencyProfile(_serviceConfiguration.lowLatency);
+    _connectionsManager.setPipeline(_serviceConfiguration.pipelineWorkers, _serviceConfiguration.pipelineQueueCapacity, parseOverflowPolicy(_serviceConfiguration.pipelineOverflow),
+        std::chrono::microseconds(_serviceConfiguration.pipelineBlockTimeoutUs));
+    _connectionsManager.setLatencyDump(std::chrono::seconds(_serviceConfiguration.latencyDumpIntervalSeconds), _serviceConfiguration.latencyDumpFile,
+        [this]() { _downloadedEvent.endEvent(); });
+    applyConfig(ConfigDiff::all());
 }
 
-void Service::updateSymbols()
+void Service::reloadConfig()
 {
-    updateConfig();
-    if(!isFileExists(_exchangeInfoFilePath))
+    auto config = Parser::tryParseTomlConfig(c_configFile);
+    if(!config)
+    {
+        spdlog::error("{} changed but can not be read, current config is kept.", c_configFile);
+        return;
+    }
+
+    const ConfigDiff diff = Parser::diffConfigs(_serviceConfiguration, *config);
+    if(diff.empty())
     {
-        spdlog::error("Json file {} is not available.", _exchangeInfoFilePath);
+        spdlog::info("{} changed, no setting differs.", c_configFile);
         return;
     }
-    _symbols = Parser::parseSecurities(_exchangeInfoFilePath);
-    _symbols = findIntersection(_symbols, _serviceConfiguration.securities, _serviceConfiguration.filter);
+
+    _serviceConfiguration = std::move(*config);
+    applyConfig(diff);
 }
 
-std::vector<std::string> Service::findIntersection(std::vector<std::string>& v, std::vector<std::string>& filter, const std::string& predicateFilter) 
+void Service::applyConfig(const ConfigDiff& diff)
 {
-    if(filter.empty())
+    const Config& config = _serviceConfiguration;
+    if(diff.timer)
+        _downloadedEvent.setTimeOut(config.timer);
+    if(diff.restEndpoint)
+        _downloadedEvent.setEndpoint(config.restHost, config.restPort);
+    if(diff.restTimeouts)
+        _downloadedEvent.setRequestTimeouts(std::chrono::milliseconds(config.restTimeoutMs), std::chrono::milliseconds(config.restIdleTimeoutMs));
+    if(diff.streamsPerConnection)
+        _connectionsManager.setStreamsPerConnection(config.streamsPerConnection);
+    if(diff.streamEndpoint)
+        _connectionsManager.setStreamEndpoint(config.streamHost, config.streamPort);
+    if(diff.reconnectPolicy)
+        _connectionsManager.setReconnectPolicy({ std::chrono::milliseconds(config.reconnectBaseDelayMs), std::chrono::milliseconds(config.reconnectMaxDelayMs), config.reconnectRetries });
+    if(diff.dnsTtl)
+        DnsCache::instance().setTtl(std::chrono::seconds(config.dnsTtlSeconds));
+    if(diff.exchangeInfoSnapshot)
+        _exchangeInfo.setSnapshotFile(config.exchangeInfoSnapshot ? _exchangeInfoFilePath : "");
+    // Securities and filter are applied by updateSymbols() right after this.
+    if(!diff.addedSecurities.empty() || !diff.removedSecurities.empty())
+        spdlog::info("Config: securities added: [{}], removed: [{}]", fmt::join(diff.addedSecurities, ", "), fmt::join(diff.removedSecurities, ", "));
+    if(!diff.requiresRestart.empty())
+        spdlog::warn("Config: {} changed, takes effect after restart", fmt::join(diff.requiresRestart, ", "));
+    spdlog::info("Config: timer: {}, filter: {}, streams per connection: {}", config.timer, config.filter, config.streamsPerConnection);
+}
+
+void Service::startConfigWatcher()
+{
+    try
+    {
+        _configWatcher = std::make_unique<ConfigWatcher>(c_configFile, [this]()
+        {
+            // Runs on watcher thread, config is parsed and applied by the update thread.
+            _configChanged = true;
+            _downloadedEvent.endEvent();
+        });
+    }
+    catch(const std::exception& e)
+    {
+        spdlog::error("Failed to watch {}: {}. Config changes are applied only after restart.", c_configFile, e.what());
+    }
+}
+
+void Service::startMetricsServer()
+{
+    if(_serviceConfiguration.metricsPort == 0)
+        return;
+
+    try
     {
-        std::vector<std::string> result;
-        std::copy_if(v.begin(), v.end(), std::back_inserter(result), [&predicateFilter](auto& v){ return v.find(predicateFilter) != std::string::npos;});
-        return result;
+        _metricsServer = std::make_unique<MetricsServer>(_serviceConfiguration.metricsAddress, static_cast<unsigned short>(_serviceConfiguration.metricsPort),
+            std::vector<MetricsServer::Collector>{ [this](MetricsText& text) { _connectionsManager.writeMetrics(text); } });
     }
+    catch(const std::exception& e)
+    {
+        spdlog::error("Failed to start metrics server on {}:{}: {}", _serviceConfiguration.metricsAddress, _serviceConfiguration.metricsPort, e.what());
+    }
+}
 
-    std::vector<std::string> result;
-    std::sort(v.begin(), v.end());
-    std::sort(filter.begin(), filter.end());
+bool Service::updateSymbols()
+{
+    auto snapshot = _exchangeInfo.latest();
+    // Snapshot of an earlier run is used only until the first download succeeds.
+    if(!snapshot && _exchangeInfo.loadSnapshotFile())
+        snapshot = _exchangeInfo.latest();
+    if(!snapshot)
+    {
+        spdlog::error("exchangeInfo is not available yet, neither downloaded nor in {}.", _exchangeInfoFilePath);
+        return false;
+    }
+
+    // Same document and same filtration as last time, nothing downstream can change.
+    if(snapshot->version == _appliedExchangeInfoVersion && _serviceConfiguration.securities == _appliedSecurities && _serviceConfiguration.filter == _appliedFilter)
+        return false;
 
-    std::vector<std::string> intersection;
-    std::set_intersection(v.begin(), v.end(), filter.begin(), filter.end(), std::back_inserter(intersection));
+    _appliedExchangeInfoVersion = snapshot->version;
+    _appliedSecurities = _serviceConfiguration.securities;
+    _appliedFilter = _serviceConfiguration.filter;
+    auto symbols = findIntersection(snapshot->symbols, _serviceConfiguration.securities, _serviceConfiguration.filter);
+    if(symbols == _symbols)
+        return false;
 
-    std::copy_if(intersection.begin(), intersection.end(), std::back_inserter(result), [&predicateFilter](auto& v){ return v.find(predicateFilter) != std::string::npos;});
+    _symbols = std::move(symbols);
+    return true;
+}
+
+std::vector<SymbolId> Service::findIntersection(const std::vector<SymbolId>& v, const std::vector<std::string>& filter, const std::string& predicateFilter) 
+{
+    const SymbolTable& table = SymbolTable::instance();
+    std::vector<SymbolId> matching = table.select(v, [&predicateFilter](std::string_view name){ return name.find(predicateFilter) != std::string_view::npos; });
+    if(filter.empty())
+        return matching;
+
+    // Keep config order: connections are established (and admitted by scheduler) in this order.
+    std::vector<SymbolId> result;
+    const SymbolSet available(matching);
+    SymbolSet added;
+    for(const auto& symbol : filter)
+    {
+        const SymbolId id = table.find(symbol);
+        if(id != c_invalidSymbolId && available.contains(id) && added.insert(id))
+            result.push_back(id);
+    }
 
     return result;
 }
@@ -116,7 +238,7 @@ bool Service::isFileExists(const std::string& filename)
     return file.good();
 }
 
-const std::vector<std::string>& Service::getSymbols() const
+const std::vector<SymbolId>& Service::getSymbols() const
 {
     return _symbols;
 }
@@ -4,34 +4,61 @@
 #include "parser.h"
 #include "webSocketsManager.h"
 #include "downloadTimerEvent.h"
+#include "metricsServer.h"
+#include "exchangeInfoStore.h"
+#include "configWatcher.h"
 
 class Service
 {
 public:
-    Service(const std::string& fp) : _exchangeInfoFilePath(fp), _downloadedEvent(30, fp, "api.binance.com", "443") {}
+    Service(const std::string& fp) : _downloadedEvent(30, _exchangeInfo, "api.binance.com", "443"), _exchangeInfoFilePath(fp) {}
 
     void run();
+
+    // Symbols of v that are listed in filter (all of v if filter is empty) and contain predicateFilter, in filter order.
+    static std::vector<SymbolId> findIntersection(const std::vector<SymbolId>& v, const std::vector<std::string>& filter, const std::string& predicateFilter);
 private:
 
     void update();
 
-    void updateConfig();
+    // Parses config.toml on start and applies all of it.
+    void loadConfig();
+
+    // Parses config.toml again after it changed on disk and applies only what differs.
+    void reloadConfig();
+
+    void applyConfig(const ConfigDiff& diff);
 
-    void updateSymbols();
+    void startMetricsServer();
 
-    std::vector<std::string> findIntersection(std::vector<std::string>& v, std::vector<std::string>& filter, const std::string& predicateFilter);
+    void startConfigWatcher();
+
+    // True if the list of symbols to subscribe changed.
+    bool updateSymbols();
 
     bool isFileExists(const std::string& filename);
 
-    const std::vector<std::string>& getSymbols() const;
+    const std::vector<SymbolId>& getSymbols() const;
 
     const std::string& getSymbolsPath() const;
 
 private:
+    static constexpr const char* c_configFile = "config.toml";
+
     WebSocketsManager _connectionsManager;
+    ExchangeInfoStore _exchangeInfo;
     DownloadOnTimerEvent<BinanceSession> _downloadedEvent;
+    // Declared after the manager, its collector must not outlive it.
+    std::unique_ptr<MetricsServer> _metricsServer;
+    std::atomic<bool> _configChanged = false;
+    // Declared after the event and flag it sets, its thread is stopped first.
+    std::unique_ptr<ConfigWatcher> _configWatcher;
     Config _serviceConfiguration;
-    std::vector<std::string> _symbols;
+    std::vector<SymbolId> _symbols;
+    // What _symbols were computed from, to skip filtering when neither changed.
+    uint64_t _appliedExchangeInfoVersion = 0;
+    std::vector<std::string> _appliedSecurities;
+    std::string _appliedFilter;
     std::string _exchangeInfoFilePath = "exchange_info.json";
 };
 
@@ -0,0 +1,47 @@
+#include "slabPool.h"
+
+#include <algorithm>
+
+SlabPool::SlabPool(size_t blockSize, size_t blocksPerSlab)
+    // Every block keeps alignment of the slab, so any object can be placed into it.
+    : _blockSize((std::max(blockSize, sizeof(void*)) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t))
+    , _blocksPerSlab(std::max<size_t>(blocksPerSlab, 1))
+{
+}
+
+void* SlabPool::allocate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_free.empty())
+    {
+        _slabs.push_back(std::make_unique<std::byte[]>(_blockSize * _blocksPerSlab));
+        std::byte* slab = _slabs.back().get();
+        // Handed out from the slab start, so consecutive objects are adjacent in memory.
+        for (size_t i = _blocksPerSlab; i-- > 0;)
+            _free.push_back(slab + i * _blockSize);
+    }
+
+    void* block = _free.back();
+    _free.pop_back();
+    return block;
+}
+
+void SlabPool::deallocate(void* block)
+{
+    if (!block)
+        return;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _free.push_back(block);
+}
+
+size_t SlabPool::blocksInUse() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _slabs.size() * _blocksPerSlab - _free.size();
+}
+
+size_t SlabPool::blocksAllocated() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _slabs.size() * _blocksPerSlab;
+}
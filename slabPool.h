@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Fixed size blocks carved from slabs of blocksPerSlab blocks. Freed blocks are handed out again before a new slab is allocated,
+// so objects that come and go with connections (clients, their read buffers) reuse the same warm memory and live next to each other.
+// Slabs are never returned to the heap. Thread safe, but meant for rare calls (connection start/stop), not the per message path.
+class SlabPool
+{
+public:
+    SlabPool(size_t blockSize, size_t blocksPerSlab);
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    void* allocate();
+
+    void deallocate(void* block);
+
+    size_t blockSize() const { return _blockSize; }
+
+    size_t blocksInUse() const;
+
+    size_t blocksAllocated() const;
+
+private:
+    const size_t _blockSize;
+    const size_t _blocksPerSlab;
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<std::byte[]>> _slabs;
+    std::vector<void*> _free;
+};
+
+// Stateless allocator that takes blocks of exactly pool's block size from the pool and anything else from the heap,
+// e.g. for beast::basic_flat_buffer that reserves its usual size once and grows past it only for unusually big frames.
+template<typename T, SlabPool& (*Pool)()>
+struct SlabAllocator
+{
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    SlabAllocator() = default;
+
+    template<typename U>
+    SlabAllocator(const SlabAllocator<U, Pool>&) noexcept {}
+
+    template<typename U>
+    struct rebind { using other = SlabAllocator<U, Pool>; };
+
+    T* allocate(size_t n)
+    {
+        if (sizeof(T) * n == Pool().blockSize())
+            return static_cast<T*>(Pool().allocate());
+        return static_cast<T*>(::operator new(sizeof(T) * n));
+    }
+
+    void deallocate(T* pointer, size_t n)
+    {
+        if (sizeof(T) * n == Pool().blockSize())
+            Pool().deallocate(pointer);
+        else
+            ::operator delete(pointer);
+    }
+
+    template<typename U>
+    bool operator==(const SlabAllocator<U, Pool>&) const noexcept { return true; }
+
+    template<typename U>
+    bool operator!=(const SlabAllocator<U, Pool>&) const noexcept { return false; }
+};
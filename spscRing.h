@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+// Bounded single-producer single-consumer ring with monotonically growing 64-bit positions.
+// Producer may also drop the oldest element when full (pushOverwrite): it claims the slot by advancing head with a CAS,
+// so consumer pops with a CAS too and throws its copy away when it lost the race. That is why T has to be trivially copyable.
+template<typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Elements are copied in and out of slots and may be read while overwritten");
+
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscRing(size_t capacity)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity)
+            rounded <<= 1;
+        _mask = rounded - 1;
+        _slots = std::make_unique<T[]>(rounded);
+    }
+
+    size_t capacity() const { return _mask + 1; }
+
+    // Any thread, approximate.
+    size_t size() const { return _tail.load(std::memory_order_relaxed) - _head.load(std::memory_order_relaxed); }
+
+    // Position of the next pushed element, any thread.
+    uint64_t tail() const { return _tail.load(std::memory_order_acquire); }
+
+    // Position of the next element to pop, any thread. Everything before it was popped or dropped.
+    uint64_t head() const { return _head.load(std::memory_order_acquire); }
+
+    // Producer side only.
+    bool tryPush(const T& value)
+    {
+        const uint64_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cachedHead > _mask)
+        {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if (tail - _cachedHead > _mask)
+                return false;
+        }
+        _slots[tail & _mask] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side only. Never fails, returns true when the oldest element was dropped to make room.
+    bool pushOverwrite(const T& value)
+    {
+        bool dropped = false;
+        const uint64_t tail = _tail.load(std::memory_order_relaxed);
+        uint64_t head = _head.load(std::memory_order_acquire);
+        while (tail - head > _mask)
+        {
+            // On failure consumer popped it meanwhile, head is reloaded and there is room now.
+            if (_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                dropped = true;
+                break;
+            }
+        }
+        _slots[tail & _mask] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return dropped;
+    }
+
+    // Consumer side only. position receives the position of the popped element.
+    bool tryPop(T& value, uint64_t& position)
+    {
+        uint64_t head = _head.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (head == _tail.load(std::memory_order_acquire))
+                return false;
+            value = _slots[head & _mask];
+            if (_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                position = head;
+                return true;
+            }
+        }
+    }
+
+private:
+    std::unique_ptr<T[]> _slots;
+    size_t _mask = 0;
+    alignas(64) std::atomic<uint64_t> _head = 0;
+    alignas(64) std::atomic<uint64_t> _tail = 0;
+    uint64_t _cachedHead = 0; // producer's copy of head, next to tail
+};
@@ -0,0 +1,168 @@
+#include "strategyPipeline.h"
+#include "tradingSystem.h"
+#include "latencyStats.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+
+OverflowPolicy parseOverflowPolicy(const std::string& name)
+{
+    if (name == "drop_oldest")
+        return OverflowPolicy::DropOldest;
+    if (name == "conflate")
+        return OverflowPolicy::Conflate;
+    if (name != "block")
+        spdlog::warn("Unknown pipeline overflow policy \"{}\", using \"block\"", name);
+    return OverflowPolicy::Block;
+}
+
+StrategyPipeline::StrategyPipeline(size_t shards, size_t workers, size_t capacity, OverflowPolicy policy, std::chrono::microseconds blockTimeout)
+    : _workers(std::clamp<size_t>(workers, 1, std::max<size_t>(shards, 1)))
+    , _policy(policy)
+    , _blockTimeout(blockTimeout)
+{
+    for (size_t i = 0; i < std::max<size_t>(shards, 1); ++i)
+        _lanes.push_back(std::make_unique<Lane>(capacity));
+}
+
+StrategyPipeline::~StrategyPipeline()
+{
+    stop();
+}
+
+void StrategyPipeline::run()
+{
+    for (size_t i = 0; i < _workers; ++i)
+        _threads.emplace_back([this, i]() { work(i); });
+    spdlog::info("Strategy pipeline: {} workers, {} rings of {} trades", _workers, _lanes.size(), _lanes.front()->ring.capacity());
+    if (_policy == OverflowPolicy::Block && _blockTimeout.count() > 0)
+        spdlog::info("Strategy pipeline: block waits at most {} us, then evicts the oldest trade", _blockTimeout.count());
+}
+
+void StrategyPipeline::stop()
+{
+    _stopping = true;
+    for (auto& thread : _threads)
+    {
+        if (thread.joinable())
+            thread.join();
+    }
+    _threads.clear();
+}
+
+bool StrategyPipeline::push(size_t shard, const PipelineItem& item)
+{
+    Lane& lane = *_lanes[shard % _lanes.size()];
+    switch (_policy)
+    {
+    case OverflowPolicy::DropOldest:
+        if (lane.ring.pushOverwrite(item))
+            ShardMetrics::add(lane.dropped);
+        return true;
+    case OverflowPolicy::Conflate:
+        return lane.ring.tryPush(item);
+    case OverflowPolicy::Block:
+    {
+        if (lane.ring.tryPush(item))
+            return true;
+        ShardMetrics::add(lane.blocked);
+        const auto deadline = std::chrono::steady_clock::now() + _blockTimeout;
+        while (!lane.ring.tryPush(item))
+        {
+            if (_stopping.load(std::memory_order_relaxed))
+                return true;
+            // Worker is stuck: with a timeout configured give up on the oldest trade instead of stalling every socket of the shard.
+            if (_blockTimeout.count() > 0 && std::chrono::steady_clock::now() >= deadline)
+            {
+                if (lane.ring.pushOverwrite(item))
+                    ShardMetrics::add(lane.evicted);
+                return true;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+    }
+    return true;
+}
+
+void StrategyPipeline::work(size_t worker)
+{
+    size_t idle = 0;
+    PipelineItem item;
+    uint64_t position = 0;
+    while (!_stopping.load(std::memory_order_relaxed))
+    {
+        bool executed = false;
+        for (size_t shard = worker; shard < _lanes.size(); shard += _workers)
+        {
+            Lane& lane = *_lanes[shard];
+            size_t popped = 0;
+            for (; popped < c_batchSize && lane.ring.tryPop(item, position); ++popped)
+            {
+                item.algorithm->execute(item.trade);
+                item.latency->recordDone(item.receivedNs, systemNowNs());
+                lane.completed.store(position + 1, std::memory_order_release);
+                executed = true;
+            }
+
+            // Lane is empty: everything before head was executed or dropped (drop_oldest, conflate), so objects retired
+            // on a quiet lane are reclaimed too instead of waiting for the next executed trade.
+            if (popped < c_batchSize)
+            {
+                const uint64_t head = lane.ring.head();
+                if (lane.completed.load(std::memory_order_relaxed) < head)
+                    lane.completed.store(head, std::memory_order_release);
+            }
+        }
+
+        if (executed)
+        {
+            idle = 0;
+        }
+        else if (++idle > c_idleSpins)
+        {
+            // Nothing for a while: stop burning the core, the cost is up to this much extra latency on the next burst.
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+void StrategyPipeline::retire(size_t shard, std::shared_ptr<void> object)
+{
+    const uint64_t position = _lanes[shard % _lanes.size()]->ring.tail();
+    std::lock_guard<std::mutex> lock(_retiredMutex);
+    _retired.push_back({ shard % _lanes.size(), position, std::move(object) });
+}
+
+void StrategyPipeline::reclaim()
+{
+    std::vector<std::shared_ptr<void>> released;
+    {
+        std::lock_guard<std::mutex> lock(_retiredMutex);
+        std::erase_if(_retired, [this, &released](Retired& retired)
+        {
+            if (_lanes[retired.shard]->completed.load(std::memory_order_acquire) < retired.position)
+                return false;
+            released.push_back(std::move(retired.object));
+            return true;
+        });
+    }
+}
+
+void StrategyPipeline::writeMetrics(MetricsText& text)
+{
+    auto perShard = [this, &text](std::string_view name, std::string_view type, std::string_view help, auto value)
+    {
+        text.family(name, type, help);
+        for (size_t shard = 0; shard < _lanes.size(); ++shard)
+            text.sample(name, static_cast<double>(value(*_lanes[shard])), fmt::format("shard=\"{}\"", shard));
+    };
+    perShard("scrapper_pipeline_queue_depth", "gauge", "Trades waiting for a strategy worker.", [](const Lane& lane) { return lane.ring.size(); });
+    perShard("scrapper_pipeline_dropped_total", "counter", "Oldest trades dropped on full ring (drop_oldest).", [](const Lane& lane) { return lane.dropped.load(std::memory_order_relaxed); });
+    perShard("scrapper_pipeline_conflated_total", "counter", "Trades replaced by a newer trade of the same symbol (conflate).", [](const Lane& lane) { return lane.conflated.load(std::memory_order_relaxed); });
+    perShard("scrapper_pipeline_blocked_total", "counter", "Pushes that had to wait for the worker (block).", [](const Lane& lane) { return lane.blocked.load(std::memory_order_relaxed); });
+    perShard("scrapper_pipeline_block_evicted_total", "counter", "Oldest trades evicted after waiting block_timeout_us for the worker (block).", [](const Lane& lane) { return lane.evicted.load(std::memory_order_relaxed); });
+}
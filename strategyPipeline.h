@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "aggTradeDecoder.h"
+#include "spscRing.h"
+#include "metrics.h"
+
+class TradingAlgorithm;
+struct SymbolLatency;
+
+enum class OverflowPolicy
+{
+    Block,      // io thread waits for the worker (backpressures the socket), lossless unless a block timeout is set: then the oldest trade is evicted after it
+    DropOldest, // oldest queued trade is dropped
+    Conflate,   // connection keeps only the latest not yet queued trade per symbol
+};
+
+// "block", "drop_oldest" or "conflate", anything else is Block.
+OverflowPolicy parseOverflowPolicy(const std::string& name);
+
+// Decoded trade handed from an io thread to a strategy worker.
+struct PipelineItem
+{
+    TradingAlgorithm* algorithm = nullptr;
+    SymbolLatency* latency = nullptr;
+    int64_t receivedNs = 0;
+    AggTrade trade;
+};
+
+// Moves strategy execution off io threads: every io thread (shard) pushes into its own SPSC ring,
+// every ring is consumed by exactly one worker thread (shard % workers), so a symbol is still executed by a single thread in order.
+// Per symbol objects referenced by queued items are retired instead of destroyed and reclaimed once the worker has passed them.
+class StrategyPipeline
+{
+public:
+    // blockTimeout bounds one wait of the Block policy, zero waits as long as it takes.
+    StrategyPipeline(size_t shards, size_t workers, size_t capacity, OverflowPolicy policy, std::chrono::microseconds blockTimeout = {});
+
+    ~StrategyPipeline();
+
+    StrategyPipeline(const StrategyPipeline&) = delete;
+    StrategyPipeline& operator=(const StrategyPipeline&) = delete;
+
+    void run();
+
+    void stop();
+
+    OverflowPolicy policy() const { return _policy; }
+
+    // io thread of the shard only. Returns false only for Conflate policy when the ring is full, caller keeps the item.
+    bool push(size_t shard, const PipelineItem& item);
+
+    // io thread of the shard only.
+    void countConflated(size_t shard) { ShardMetrics::add(_lanes[shard % _lanes.size()]->conflated); }
+
+    // Any thread. Keeps the object alive until everything queued on the shard so far has been executed.
+    void retire(size_t shard, std::shared_ptr<void> object);
+
+    // Any thread. Frees retired objects workers are done with.
+    void reclaim();
+
+    // Queue depth and overflow counters per shard.
+    void writeMetrics(MetricsText& text);
+
+private:
+    struct alignas(64) Lane
+    {
+        explicit Lane(size_t capacity) : ring(capacity) {}
+
+        SpscRing<PipelineItem> ring;
+        alignas(64) std::atomic<uint64_t> completed = 0; // position after the last executed item, written by worker
+        // Written by the io thread only.
+        alignas(64) std::atomic<uint64_t> dropped = 0;
+        std::atomic<uint64_t> conflated = 0;
+        std::atomic<uint64_t> blocked = 0;
+        std::atomic<uint64_t> evicted = 0;
+    };
+
+    struct Retired
+    {
+        size_t shard;
+        uint64_t position;
+        std::shared_ptr<void> object;
+    };
+
+    void work(size_t worker);
+
+private:
+    static constexpr size_t c_batchSize = 64;
+    static constexpr size_t c_idleSpins = 1024;
+    std::vector<std::unique_ptr<Lane>> _lanes;
+    size_t _workers = 1;
+    OverflowPolicy _policy = OverflowPolicy::Block;
+    // Longest stall of an io thread under Block policy, the other connections of the shard wait for it too.
+    std::chrono::microseconds _blockTimeout{ 0 };
+    std::vector<std::thread> _threads;
+    std::atomic<bool> _stopping = false;
+    std::mutex _retiredMutex;
+    std::vector<Retired> _retired;
+};
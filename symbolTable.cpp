@@ -0,0 +1,91 @@
+#include "symbolTable.h"
+
+#include <mutex>
+#include <stdexcept>
+
+SymbolTable& SymbolTable::instance()
+{
+    static SymbolTable table;
+    return table;
+}
+
+SymbolId SymbolTable::intern(std::string_view symbol)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        if (auto it = _ids.find(symbol); it != _ids.end())
+            return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    if (auto it = _ids.find(symbol); it != _ids.end())
+        return it->second;
+
+    const SymbolId id = static_cast<SymbolId>(_names.size());
+    if (id == c_invalidSymbolId)
+        throw std::length_error("Symbol table is full");
+    _names.emplace_back(symbol);
+    _ids.emplace(_names.back(), id);
+    return id;
+}
+
+SymbolId SymbolTable::find(std::string_view symbol) const
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    auto it = _ids.find(symbol);
+    return it != _ids.end() ? it->second : c_invalidSymbolId;
+}
+
+const std::string& SymbolTable::name(SymbolId id) const
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _names.at(id);
+}
+
+size_t SymbolTable::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    return _names.size();
+}
+
+void SymbolSet::assign(const std::vector<SymbolId>& ids)
+{
+    clear();
+    _ids.reserve(ids.size());
+    for (SymbolId id : ids)
+        insert(id);
+}
+
+bool SymbolSet::insert(SymbolId id)
+{
+    uint8_t& member = _member[id];
+    if (member)
+        return false;
+    member = 1;
+    _ids.push_back(id);
+    return true;
+}
+
+void SymbolSet::clear()
+{
+    // Flags are reset one by one, so clear() costs the size of the set and not of the whole id range.
+    for (SymbolId id : _ids)
+        _member.reset(id);
+    _ids.clear();
+}
+
+SymbolDiff SymbolSet::diff(const SymbolSet& previous, const SymbolSet& current)
+{
+    SymbolDiff result;
+    for (SymbolId id : current._ids)
+    {
+        if (!previous.contains(id))
+            result.added.push_back(id);
+    }
+    for (SymbolId id : previous._ids)
+    {
+        if (!current.contains(id))
+            result.removed.push_back(id);
+    }
+    return result;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Dense id of an interned symbol, ids start at 0 and are never reused, so they index flat per symbol arrays.
+using SymbolId = uint32_t;
+
+constexpr SymbolId c_invalidSymbolId = UINT32_MAX;
+
+// Process wide table of symbols (lowercase names, as used in stream names). Each name is stored once and gets the next id.
+// Thread safe: interning takes an exclusive lock, lookups a shared one. Names are never removed, references to them stay valid.
+class SymbolTable
+{
+public:
+    static SymbolTable& instance();
+
+    SymbolId intern(std::string_view symbol);
+
+    // c_invalidSymbolId if symbol was never interned.
+    SymbolId find(std::string_view symbol) const;
+
+    const std::string& name(SymbolId id) const;
+
+    // Ids whose name satisfies predicate(name), in order of ids. Takes the lock once for the whole list.
+    template<typename Predicate>
+    std::vector<SymbolId> select(const std::vector<SymbolId>& ids, Predicate&& predicate) const
+    {
+        std::vector<SymbolId> result;
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        for (SymbolId id : ids)
+        {
+            if (predicate(std::string_view(_names.at(id))))
+                result.push_back(id);
+        }
+        return result;
+    }
+
+    size_t size() const;
+
+private:
+    struct Hash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    mutable std::shared_mutex _mutex;
+    // deque never moves stored strings, so views of them are used as keys.
+    std::deque<std::string> _names;
+    std::unordered_map<std::string_view, SymbolId, Hash, std::equal_to<>> _ids;
+};
+
+// Per symbol state in a flat array indexed by SymbolId, grows on demand up to the largest id used.
+template<typename T>
+class SymbolMap
+{
+public:
+    explicit SymbolMap(T empty = T{}) : _empty(empty) {}
+
+    T& operator[](SymbolId id)
+    {
+        if (id >= _values.size())
+            _values.resize(static_cast<size_t>(id) + 1, _empty);
+        return _values[id];
+    }
+
+    const T& get(SymbolId id) const { return id < _values.size() ? _values[id] : _empty; }
+
+    void reset(SymbolId id)
+    {
+        if (id < _values.size())
+            _values[id] = _empty;
+    }
+
+private:
+    T _empty;
+    std::vector<T> _values;
+};
+
+// Added and removed ids between two symbol sets.
+struct SymbolDiff
+{
+    std::vector<SymbolId> added;
+    std::vector<SymbolId> removed;
+};
+
+// Set of symbol ids: list of members in insertion order plus flat membership flags, so contains() is one array load.
+class SymbolSet
+{
+public:
+    SymbolSet() = default;
+
+    explicit SymbolSet(const std::vector<SymbolId>& ids) { assign(ids); }
+
+    // Duplicates are kept only once.
+    void assign(const std::vector<SymbolId>& ids);
+
+    bool insert(SymbolId id);
+
+    bool contains(SymbolId id) const { return _member.get(id) != 0; }
+
+    void clear();
+
+    size_t size() const { return _ids.size(); }
+
+    bool empty() const { return _ids.empty(); }
+
+    const std::vector<SymbolId>& ids() const { return _ids; }
+
+    // Linear in size of both sets, no hashing and no sorting.
+    static SymbolDiff diff(const SymbolSet& previous, const SymbolSet& current);
+
+private:
+    std::vector<SymbolId> _ids;
+    SymbolMap<uint8_t> _member;
+};
@@ -0,0 +1,65 @@
+#include "tlsSessionCache.h"
+
+#include <spdlog/spdlog.h>
+
+TlsSessionCache& TlsSessionCache::instance()
+{
+    static TlsSessionCache cache;
+    return cache;
+}
+
+TlsSessionCache::TlsSessionCache()
+{
+    _keyIndex = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+}
+
+TlsSessionCache::~TlsSessionCache()
+{
+    for (auto& [key, session] : _sessions)
+    {
+        if (session)
+            SSL_SESSION_free(session);
+    }
+}
+
+void TlsSessionCache::attach(boost::asio::ssl::context& ctx)
+{
+    // Internal OpenSSL store is not used, sessions are kept here so several contexts can share them.
+    SSL_CTX_set_session_cache_mode(ctx.native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx.native_handle(), &TlsSessionCache::onNewSession);
+}
+
+void TlsSessionCache::prepare(SSL* ssl, const std::string& host, const std::string& port)
+{
+    if (!SSL_set_tlsext_host_name(ssl, host.c_str()))
+        spdlog::warn("Failed to set SNI host name {}", host);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto [it, inserted] = _sessions.try_emplace(host + ":" + port, nullptr);
+    SSL_set_ex_data(ssl, _keyIndex, const_cast<std::string*>(&it->first));
+    if (it->second)
+        SSL_set_session(ssl, it->second);
+}
+
+void TlsSessionCache::onHandshake(SSL* ssl)
+{
+    if (SSL_session_reused(ssl))
+        ++_resumed;
+    else
+        ++_full;
+}
+
+int TlsSessionCache::onNewSession(SSL* ssl, SSL_SESSION* session)
+{
+    TlsSessionCache& cache = instance();
+    auto* key = static_cast<std::string*>(SSL_get_ex_data(ssl, cache._keyIndex));
+    if (!key)
+        return 0; // connection was not prepared by us, let OpenSSL free the session
+
+    std::lock_guard<std::mutex> lock(cache._mutex);
+    SSL_SESSION*& stored = cache._sessions[*key];
+    if (stored)
+        SSL_SESSION_free(stored);
+    stored = session;
+    return 1; // we keep the reference
+}
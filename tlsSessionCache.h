@@ -0,0 +1,47 @@
+#pragma once
+
+#include <boost/asio/ssl/context.hpp>
+
+#include <openssl/ssl.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Process wide client side TLS session cache keyed by "host:port".
+// Sessions (ids or tickets) captured after a full handshake are offered on the next connect to the same endpoint,
+// so reconnects do an abbreviated handshake instead of a full one.
+class TlsSessionCache
+{
+public:
+    static TlsSessionCache& instance();
+
+    ~TlsSessionCache();
+
+    // Enables client session caching on ctx and captures every new session negotiated with it.
+    void attach(boost::asio::ssl::context& ctx);
+
+    // Call before SSL handshake: sets SNI and offers cached session for host:port, if any.
+    void prepare(SSL* ssl, const std::string& host, const std::string& port);
+
+    // Call after successful SSL handshake to count resumed vs full handshakes.
+    void onHandshake(SSL* ssl);
+
+    uint64_t resumedHandshakes() const { return _resumed; }
+
+    uint64_t fullHandshakes() const { return _full; }
+
+private:
+    TlsSessionCache();
+
+    static int onNewSession(SSL* ssl, SSL_SESSION* session);
+
+private:
+    std::mutex _mutex;
+    // Key strings are referenced from SSL ex data, node based map keeps their address stable.
+    std::unordered_map<std::string, SSL_SESSION*> _sessions;
+    std::atomic<uint64_t> _resumed = 0;
+    std::atomic<uint64_t> _full = 0;
+    int _keyIndex = -1;
+};
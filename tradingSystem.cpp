@@ -1,99 +1,70 @@
 #include "tradingSystem.h"
 
-#include <iostream>
-#include <sstream>
-#include <iomanip>
-#include <map>
-#include <algorithm>
-#include <cctype>
-#include <random>
-
 #include "spdlog/spdlog.h"
-#include <nlohmann/json.hpp>
 
-std::string TradingAlgorithm::execute(const std::string& json_string) 
+const char* toString(Signal signal)
 {
-    nlohmann::json json_data;
-    try
-    {
-        json_data = nlohmann::json::parse(json_string);
-    }
-    catch (const std::exception& e) 
-    {
-        spdlog::error("Failed to parse JSON: {}", e.what());
-        return "ERROR: Invalid JSON";
-    }
-
-    std::string event_type = json_data["e"];
-    double price = std::stod(json_data["p"].get<std::string>());
-    double quantity = std::stod(json_data["q"].get<std::string>());
-    _id = json_data["s"];
-
-    _priceHistory.push_back(price);
-    if (_priceHistory.size() > _longWindow) 
-    {
-        _priceHistory.pop_front();
-    }
-
-    if (_priceHistory.size() >= _longWindow) 
+    switch (signal)
     {
-        double short_ma = calculateMovingAverage(_shortWindow);
-        double long_ma = calculateMovingAverage(_longWindow);
-        std::string prediction = analyzeMovingAverage(short_ma, long_ma);
-
-        simulateTrade(prediction, price, quantity);
-        return prediction;
+    case Signal::Wait: return "WAIT";
+    case Signal::Hold: return "HOLD";
+    case Signal::Long: return "LONG";
+    case Signal::Short: return "SHORT";
+    case Signal::Invalid: return "INVALID";
     }
-
-    return "WAIT";
+    return "UNKNOWN";
 }
 
-double TradingAlgorithm::getMeanProfit() const 
+Signal TradingAlgorithm::execute(std::string_view json_string) 
 {
-    if (_tradeProfits.empty()) 
-        return 0.0;
-    double sum = 0.0;
-    for (double profit : _tradeProfits) 
+    AggTrade trade;
+    if (!AggTradeDecoder::decode(json_string, trade))
     {
-        sum += profit;
+        spdlog::error("Failed to parse aggTrade: {}", json_string);
+        return Signal::Invalid;
     }
-    return sum;
+    return execute(trade);
 }
 
-void TradingAlgorithm::simulateTrade(const std::string& prediction, double price, double quantity) 
+Signal TradingAlgorithm::execute(const AggTrade& trade) 
 {
-    double profit = 0.0;
+    const double price = trade.price;
+    const double quantity = trade.quantity;
+    if (_id != trade.getSymbol())
+        _id = trade.getSymbol();
+
+    _window.push(price);
+    if (!_window.full())
+        return Signal::Wait;
+
+    const Signal prediction = analyzeMovingAverage(_window.shortAverage(), _window.longAverage());
+    simulateTrade(prediction, price, quantity);
+    return prediction;
+}
 
-    if (prediction == "LONG" && _currentBalance >= price * quantity) 
+void TradingAlgorithm::simulateTrade(Signal prediction, double price, double quantity) 
+{
+    if (prediction == Signal::Long && _currentBalance >= price * quantity) 
     {
         _position += quantity;
         _currentBalance -= price * quantity;
         spdlog::info("{}: Bought {} at price {}. Current Balance: {}. Current Profit {}.", _id, quantity, price, _currentBalance, getMeanProfit());
     }
-    else if (prediction == "SHORT" && _position >= quantity) 
+    else if (prediction == Signal::Short && _position >= quantity) 
     {
-        profit = price * quantity; 
+        const double profit = price * quantity; 
         _currentBalance += profit;
         _position -= quantity; 
+        _totalProfit += profit;
         spdlog::info("{}: Sold {} at price {}. Profit: {}, Current Balance: {}. Current Profit {}.", _id, quantity, price, profit, _currentBalance, getMeanProfit());
     }
-    _tradeProfits.push_back(profit);
 }
 
-double  TradingAlgorithm::calculateMovingAverage(int windowSize) 
-{
-    double sum = 0.0;
-    for (size_t i = _priceHistory.size() - windowSize; i < _priceHistory.size(); ++i)
-        sum += _priceHistory[i];
-    return sum / windowSize;
-}
-
-std::string TradingAlgorithm::analyzeMovingAverage(double shortma, double longma) 
+Signal TradingAlgorithm::analyzeMovingAverage(double shortma, double longma) 
 {
     if (shortma > longma)
-        return "LONG";
+        return Signal::Long;
     else if (shortma < longma) 
-        return "SHORT"; 
-    return "HOLD"; 
+        return Signal::Short; 
+    return Signal::Hold; 
 }
-
@@ -1,33 +1,48 @@
 #pragma once
 
-#include <deque>
+#include <cstdint>
 #include <string>
-#include <vector>
+#include <string_view>
+
+#include "aggTradeDecoder.h"
+#include "priceWindow.h"
+
+// Outcome of one trade for the strategy.
+enum class Signal : uint8_t
+{
+    Wait,    // long window not filled yet
+    Hold,    // averages are equal
+    Long,
+    Short,
+    Invalid, // message could not be decoded
+};
+
+const char* toString(Signal signal);
 
 class TradingAlgorithm {
 public:
-    TradingAlgorithm(double sw = 5, double lw = 20, double initB = 1000000.0)
-        : _shortWindow(sw), _longWindow(lw), _initialBalance(initB), _currentBalance(initB) {}
+    // Windows are counted in trades and may be arbitrarily long, cost per trade is the same.
+    TradingAlgorithm(size_t sw = 5, size_t lw = 20, double initB = 1000000.0)
+        : _window(sw, lw), _initialBalance(initB), _currentBalance(initB) {}
 
-    std::string execute(const std::string& json_string); 
+    // json_string may point straight into the socket buffer, it is not retained after return.
+    Signal execute(std::string_view json_string); 
+
+    Signal execute(const AggTrade& trade);
         
-    double getMeanProfit() const; 
+    // Sum of profits of all simulated trades, kept as a running total.
+    double getMeanProfit() const { return _totalProfit; }
     
 private: 
-    void simulateTrade(const std::string& prediction, double price, double quantity); 
-
-    double calculateMovingAverage(int windowSize); 
+    void simulateTrade(Signal prediction, double price, double quantity); 
 
-    std::string analyzeMovingAverage(double shortma, double longma);
+    static Signal analyzeMovingAverage(double shortma, double longma);
 
 private:
-    double _shortWindow;
-    double _longWindow;
-    std::deque<double> _priceHistory;
-    std::vector<double> _tradeProfits; 
+    PriceWindow _window;
+    double _totalProfit = 0.0;
     double _initialBalance;
     double _currentBalance;
-    double _position;
+    double _position = 0.0;
     std::string _id;
 };
-
@@ -1,18 +1,131 @@
 #include "webSocketConnection.h"
+#include "tlsSessionCache.h"
+#include "dnsCache.h"
 
 #include <chrono>
 #include <thread>
 #include <ctime>
 #include <cstdlib>
 
+namespace
+{
+    // Few hundred clients at most per shard, one slab keeps a typical deployment in one contiguous block.
+    constexpr size_t c_clientsPerSlab = 64;
+    constexpr size_t c_readBuffersPerSlab = 16;
+}
+
+SlabPool& readBufferPool()
+{
+    static SlabPool pool(WebSocketClient::c_initialBufferSize, c_readBuffersPerSlab);
+    return pool;
+}
+
+SlabPool& WebSocketClient::clientPool()
+{
+    static SlabPool pool(sizeof(WebSocketClient), c_clientsPerSlab);
+    return pool;
+}
+
+void* WebSocketClient::operator new(size_t size)
+{
+    static_assert(alignof(WebSocketClient) <= alignof(std::max_align_t), "Slab blocks are aligned to max_align_t");
+    return size == sizeof(WebSocketClient) ? clientPool().allocate() : ::operator new(size);
+}
+
+void WebSocketClient::operator delete(void* pointer, size_t size)
+{
+    if (size == sizeof(WebSocketClient))
+        clientPool().deallocate(pointer);
+    else
+        ::operator delete(pointer);
+}
+
+WebSocketClient::~WebSocketClient()
+{
+    for (auto& [symbol, stream] : algorithms_)
+        retireStream(stream);
+}
+
+void WebSocketClient::retireStream(SymbolStream& stream)
+{
+    LatencyRegistry::instance().remove(stream.latency);
+    if (!pipeline_)
+        return;
+
+    conflated_.erase(stream.algorithm.get());
+    pipeline_->retire(shard_, std::shared_ptr<TradingAlgorithm>(std::move(stream.algorithm)));
+    pipeline_->retire(shard_, std::move(stream.latency));
+}
+
 void WebSocketClient::run() 
 {
     stopped_ = false;
     if (stopping_) return; 
 
-    resolver_.async_resolve(host_, port_,
-        [this](beast::error_code ec, net::ip::tcp::resolver::results_type results) 
+    requestConnect();
+}
+
+void WebSocketClient::requestConnect()
+{
+    if (!scheduler_)
+    {
+        net::post(ioc_, [this, self = weak_from_this()]()
+        {
+            if (const auto owner = self.lock())
+                connect();
+        });
+        return;
+    }
+
+    // Wait for a handshake slot and connection rate budget, so thousands of connects do not start at once.
+    // Runs on the scheduler's thread, the client may be dropped by the manager meanwhile: it is used only through a locked owner.
+    scheduler_->submit([this, scheduler = scheduler_, self = weak_from_this()]()
+    {
+        const auto owner = self.lock();
+        if (!owner)
+            return scheduler->finished(false);
+
+        net::post(ioc_, [this, scheduler, self]()
+        {
+            const auto owner = self.lock();
+            if (!owner)
+                return scheduler->finished(false);
+            admitted_ = true;
+            connect();
+        });
+    });
+}
+
+void WebSocketClient::releaseAdmission(bool connected)
+{
+    if (admitted_)
+    {
+        admitted_ = false;
+        scheduler_->finished(connected);
+    }
+}
+
+void WebSocketClient::connect()
+{
+    if (stopping_ || stopped_)
+        return releaseAdmission(false);
+
+    // Resolve, TCP connect, TLS and websocket handshakes must finish in time, a hung attempt would keep its scheduler slot forever.
+    connectTimer_.expires_after(c_connectTimeout);
+    connectTimer_.async_wait([this, self = shared_from_this(), generation = generation_](beast::error_code ec)
+    {
+        if (ec || generation != generation_ || connected_ || stopping_ || stopped_)
+            return;
+        fail(beast::error::timeout, "connect timeout");
+    });
+
+    DnsCache::instance().asyncResolve(host_, port_, ioc_.get_executor(),
+        [this, self = weak_from_this(), generation = generation_](const beast::error_code& ec, const net::ip::tcp::resolver::results_type& results) 
         {
+            // Manager may drop the client on another thread at any moment, the owner keeps it alive until this returns.
+            const auto owner = self.lock();
+            if (!owner || stopping_ || stopped_ || generation != generation_)
+                return;
             if (ec) 
                 return fail(ec, "resolve");
             onResolve(results);
@@ -22,33 +135,145 @@ void WebSocketClient::run()
 void WebSocketClient::stop()
 {
     stopping_ = true;
-    //cancelSSL();
-    if (ws_.is_open())
+    net::post(ioc_, [this, self = shared_from_this()]()
+    {
+        controlTimer_.cancel();
+        reconnectTimer_.cancel();
+        stableTimer_.cancel();
+        connectTimer_.cancel();
+        conflatedFlushTimer_.cancel();
+        releaseAdmission(false);
+        //cancelSSL();
+        if (ws_->is_open())
+        {
+            try
+            {
+                closeConnectionAsync();
+            }
+            catch (const std::exception& e)
+            {
+                spdlog::error("Exception while initiating async_close for WebSocket {}: {}", endpoint_, e.what());
+            }
+        }
+        else if (connecting_)
+        {
+            // TCP connect or a handshake is in flight: closing the socket aborts it, its completion marks the client stopped.
+            beast::error_code ignored;
+            beast::get_lowest_layer(*ws_).close(ignored);
+        }
+        else
+        {
+            // Nothing to close (failed before or during handshake, or still waiting for DNS or a scheduler slot), so it is safe to drop this client.
+            spdlog::info("WebSocket {} is already closed.", endpoint_);
+            stopping_ = false;
+            stopped_ = true;
+        }
+    });
+}
+
+void WebSocketClient::subscribe(const std::vector<SymbolId>& symbols)
+{
+    net::post(ioc_, [this, self = shared_from_this(), symbols]()
     {
-        try
+        for (SymbolId id : symbols)
         {
-            closeConnectionAsync();
+            // Frames are routed by the name in their stream field, so streams stay keyed by name.
+            const std::string& symbol = SymbolTable::instance().name(id);
+            auto [it, inserted] = algorithms_.try_emplace(symbol);
+            if (!inserted)
+                continue;
+            it->second.id = id;
+            it->second.latency = LatencyRegistry::instance().add(symbol, shard_, this);
+            // Once the URL is built the symbol can only be added in-band, the message waits for the handshake if needed.
+            if (urlBuilt_)
+                pendingSubscribe_.push_back(symbol + "@aggTrade");
         }
-        catch (const std::exception& e)
+        queueControlMessage("SUBSCRIBE", pendingSubscribe_);
+    });
+}
+
+void WebSocketClient::unsubscribe(const std::vector<SymbolId>& symbols)
+{
+    net::post(ioc_, [this, self = shared_from_this(), symbols]()
+    {
+        for (SymbolId id : symbols)
         {
-            spdlog::error("Exception while initiating async_close for WebSocket {}: {}", symbol_, e.what());
+            const std::string& symbol = SymbolTable::instance().name(id);
+            auto it = algorithms_.find(symbol);
+            if (it == algorithms_.end())
+                continue;
+            retireStream(it->second);
+            algorithms_.erase(it);
+            if (urlBuilt_)
+                pendingUnsubscribe_.push_back(symbol + "@aggTrade");
         }
+        queueControlMessage("UNSUBSCRIBE", pendingUnsubscribe_);
+    });
+}
+
+void WebSocketClient::queueControlMessage(const char* method, std::vector<std::string>& streams)
+{
+    for (size_t i = 0; i < streams.size(); i += c_maxStreamsPerControlMessage)
+    {
+        std::string message = std::string("{\"method\":\"") + method + "\",\"params\":[";
+        for (size_t j = i; j < std::min(streams.size(), i + c_maxStreamsPerControlMessage); ++j)
+        {
+            if (j != i)
+                message += ',';
+            message += '"' + streams[j] + '"';
+        }
+        message += "],\"id\":" + std::to_string(++controlMessageId_) + "}";
+        controlMessages_.push_back(std::move(message));
     }
-    else
+    streams.clear();
+
+    if (!writing_)
+        writeControlMessage();
+}
+
+void WebSocketClient::writeControlMessage()
+{
+    if (controlMessages_.empty() || stopping_ || !connected_)
     {
-        spdlog::info("WebSocket {} is already closed.", symbol_);
+        writing_ = false;
+        return;
     }
+
+    writing_ = true;
+    ws_->async_write(net::buffer(controlMessages_.front()),
+        [this, self = shared_from_this(), generation = generation_](beast::error_code ec, std::size_t)
+        {
+            if (generation != generation_)
+                return;
+            if (ec)
+            {
+                writing_ = false;
+                return fail(ec, "write");
+            }
+
+            controlMessages_.pop_front();
+            controlTimer_.expires_after(c_controlMessageInterval);
+            controlTimer_.async_wait([this, self, generation](beast::error_code ec)
+            {
+                if (ec || generation != generation_)
+                {
+                    writing_ = false;
+                    return;
+                }
+                writeControlMessage();
+            });
+        });
 }
 
 void WebSocketClient::cancelSSL()
 {
     try
     {
-        ws_.next_layer().next_layer().cancel(); // Cancel SSL operations
+        ws_->next_layer().next_layer().cancel(); // Cancel SSL operations
     }
     catch (const std::exception& e)
     {
-        spdlog::error("Exception while cancelling SSL operations for WebSocket {}: {}", symbol_, e.what());
+        spdlog::error("Exception while cancelling SSL operations for WebSocket {}: {}", endpoint_, e.what());
         // .. what can we do ?..
     }
 }
@@ -56,8 +281,8 @@ void WebSocketClient::cancelSSL()
 void WebSocketClient::closeConnectionAsync()
 {
     beast::error_code ec;
-    ws_.async_close(beast::websocket::close_code::normal,
-        [this](beast::error_code ec)
+    ws_->async_close(beast::websocket::close_code::normal,
+        [this, self = shared_from_this()](beast::error_code ec)
         {
             onClose(ec);
         });
@@ -67,10 +292,10 @@ void WebSocketClient::onClose(beast::error_code ec)
 {
     if (ec && ec != net::error::eof && ec != boost::asio::error::operation_aborted && ec != boost::asio::ssl::error::stream_truncated)
     {
-        spdlog::error("WebSocket {} failed to close: {}", symbol_, ec.message());
+        spdlog::error("WebSocket {} failed to close: {}", endpoint_, ec.message());
         return;
     }
-    spdlog::info("WebSocket {} closed successfully.", symbol_);
+    spdlog::info("WebSocket {} closed successfully.", endpoint_);
 
     stopping_ = false; // dont like this
     stopped_ = true;
@@ -78,31 +303,58 @@ void WebSocketClient::onClose(beast::error_code ec)
 
 void WebSocketClient::onResolve(net::ip::tcp::resolver::results_type results) 
 {
-    net::async_connect(ws_.next_layer().next_layer(), results,
-        [this](beast::error_code ec, net::ip::tcp::endpoint ep) 
+    connecting_ = true;
+    net::async_connect(ws_->next_layer().next_layer(), results,
+        [this, self = shared_from_this(), generation = generation_](beast::error_code ec, const net::ip::tcp::endpoint&) 
         {
+            if (generation != generation_)
+                return;
+            if (stopping_)
+                return onConnectAborted();
             if (ec) 
                 return fail(ec, "connect");
-            onConnect(ep);
+            onConnect();
         });
 }
 
-void WebSocketClient::onConnect(net::ip::tcp::endpoint ep) 
+void WebSocketClient::onConnect() 
 {
-    ws_.next_layer().async_handshake(ssl::stream_base::client,
-        [this](beast::error_code ec) 
+    lowLatency_.applyToSocket(beast::get_lowest_layer(*ws_));
+    TlsSessionCache::instance().prepare(ws_->next_layer().native_handle(), host_, port_);
+    ws_->next_layer().async_handshake(ssl::stream_base::client,
+        [this, self = shared_from_this(), generation = generation_](beast::error_code ec) 
         {
+            if (generation != generation_)
+                return;
+            if (stopping_)
+                return onConnectAborted();
             if (ec) 
                 return fail(ec, "ssl_handshake");
+            TlsSessionCache::instance().onHandshake(ws_->next_layer().native_handle());
             onSslHandshake();
         });
 }
 
 void WebSocketClient::onSslHandshake() 
 {
-    ws_.async_handshake(host_, endpoint_,
-        [this](beast::error_code ec) 
+    endpoint_ = "/stream?streams=";
+    urlBuilt_ = true;
+    size_t streamsInUrl = 0;
+    for (const auto& [symbol, stream] : algorithms_)
+    {
+        if (streamsInUrl++ < c_maxStreamsInUrl)
+            endpoint_ += (streamsInUrl > 1 ? "/" : "") + symbol + "@aggTrade";
+        else
+            pendingSubscribe_.push_back(symbol + "@aggTrade");
+    }
+
+    ws_->async_handshake(host_, endpoint_,
+        [this, self = shared_from_this(), generation = generation_](beast::error_code ec) 
         {
+            if (generation != generation_)
+                return;
+            if (stopping_)
+                return onConnectAborted();
             if (ec) 
                 return fail(ec, "handshake");
             onHandshake();
@@ -111,28 +363,65 @@ void WebSocketClient::onSslHandshake()
 
 void WebSocketClient::onHandshake() 
 {
-    spdlog::info("WebSocket {}, connected to {}", symbol_, endpoint_);
+    spdlog::info("WebSocket connected with {} streams", algorithms_.size());
+    connected_ = true;
+    connecting_ = false;
+    connectTimer_.cancel();
+    releaseAdmission(true);
+    scheduleStableReset();
+    if (disconnectedAt_)
+    {
+        const uint64_t recoveryMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - *disconnectedAt_).count();
+        lastRecoveryMs_ = recoveryMs;
+        maxRecoveryMs_ = std::max<uint64_t>(maxRecoveryMs_, recoveryMs);
+        ++reconnects_;
+        metrics_.add(metrics_.reconnects);
+        disconnectedAt_.reset();
+        spdlog::info("WebSocket {} recovered in {} ms", endpoint_, recoveryMs);
+    }
+    queueControlMessage("SUBSCRIBE", pendingSubscribe_);
     readMessage(); 
 }
 
+void WebSocketClient::onConnectAborted()
+{
+    // stop() closed the socket under this step (or the step completed just before), no other operation holds the stream.
+    connecting_ = false;
+    beast::error_code ignored;
+    beast::get_lowest_layer(*ws_).close(ignored);
+    spdlog::info("WebSocket {} connect aborted by stop.", endpoint_);
+    stopping_ = false;
+    stopped_ = true;
+}
+
+void WebSocketClient::scheduleStableReset()
+{
+    // A server that accepts and closes right away must not get a fresh retry budget on every handshake.
+    stableTimer_.expires_after(c_stableConnectionInterval);
+    stableTimer_.async_wait([this, self = shared_from_this(), generation = generation_](beast::error_code ec)
+    {
+        if (ec || generation != generation_ || !connected_)
+            return;
+        reconnectAttempts_ = 0;
+    });
+}
+
 void WebSocketClient::readMessage() 
 {
-    ws_.async_read(buffer_,
-        [this](beast::error_code ec, std::size_t bytes_transferred) 
+    ws_->async_read(buffer_, makeRecyclingHandler(readHandlerMemory_,
+        [this, self = shared_from_this(), generation = generation_](beast::error_code ec, std::size_t bytes_transferred) 
         {
-            if(stopping_ || stopped_)
+            if(stopping_ || stopped_ || generation != generation_)
                 return;
 
             if (ec) 
             {
                 if (ec == websocket::error::closed) 
                 {
-                    spdlog::info("WebSocket {} closed clearly", symbol_);
-                }
-                else 
-                {
-                    fail(ec, "read");
+                    // Exchange closes streams on its own (e.g. every 24h), reconnect as for any other drop.
+                    spdlog::info("WebSocket {} closed clearly", endpoint_);
                 }
+                fail(ec, "read");
 
                 buffer_.clear();
                 return;
@@ -152,24 +441,188 @@ void WebSocketClient::readMessage()
                 return;
             }*/
 
-            const char* dataPtr = boost::asio::buffer_cast<const char*>(buffer_.data());
-            std::string tradeData = std::string(dataPtr, buffer_.size());
-            //spdlog::info(tradeData);
-            algorithm_.execute(tradeData); // async for this to since its block whole websocket?
-
+            // Frame is handed over as a view into buffer_ and consumed only after it was processed.
+            const int64_t receivedNs = systemNowNs();
+            metrics_.add(metrics_.messages);
+            metrics_.add(metrics_.bytes, bytes_transferred);
+            const uint64_t allocationsBefore = AllocationCounter::threadAllocations();
+            const char* dataPtr = static_cast<const char*>(buffer_.data().data());
+            onFrame(std::string_view(dataPtr, buffer_.size()), receivedNs);
             buffer_.consume(bytes_transferred);
+
+            // Starting the next read is part of the per frame cost too: its state goes to readHandlerMemory_, not to the heap.
             readMessage(); // TODO: can this lead to stack overflow if read is too fast?.. 
-        });
+            allocations_.record(AllocationCounter::threadAllocations() - allocationsBefore);
+
+            if (AllocationCounter::enabled() && allocations_.messages % c_allocationReportInterval == 0)
+            {
+                spdlog::info("WebSocket {}: {} heap allocations in {} messages after warm-up ({} read operations did not fit handler memory)", endpoint_,
+                    allocations_.steadyStateAllocations, allocations_.steadyStateMessages(), readHandlerMemory_.heapAllocations());
+            }
+        }));
+}
+
+void WebSocketClient::onFrame(std::string_view frame, int64_t receivedNs)
+{
+    std::string_view symbol;
+    std::string_view data;
+    if (!AggTradeDecoder::splitCombinedFrame(frame, symbol, data))
+    {
+        // Replies to SUBSCRIBE/UNSUBSCRIBE look like {"result":null,"id":1}
+        if (frame.find("\"error\"") != std::string_view::npos)
+            spdlog::error("WebSocket {} control message failed: {}", endpoint_, frame);
+        return;
+    }
+
+    if (capture_)
+        capture_->append(shard_, receivedNs, symbol, frame);
+
+    auto it = algorithms_.find(symbol);
+    if (it == algorithms_.end())
+        return; // late frame of unsubscribed stream
+
+    AggTrade trade;
+    if (!AggTradeDecoder::decode(data, trade))
+    {
+        metrics_.add(metrics_.parseErrors);
+        if (parseErrors_++ % c_parseErrorsLogInterval == 0)
+            spdlog::error("WebSocket {}: failed to parse aggTrade ({} so far): {}", endpoint_, parseErrors_, data);
+        return;
+    }
+
+    //spdlog::info(data);
+    SymbolStream& stream = it->second;
+    stream.latency->recordReceive(trade.eventTime, receivedNs);
+    if (!pipeline_)
+    {
+        stream.algorithm->execute(trade);
+        stream.latency->recordDone(receivedNs, systemNowNs());
+        return;
+    }
+
+    const PipelineItem item{ stream.algorithm.get(), stream.latency.get(), receivedNs, trade };
+    if (pipeline_->policy() == OverflowPolicy::Conflate)
+        enqueueConflated(item);
+    else
+        pipeline_->push(shard_, item);
+}
+
+void WebSocketClient::enqueueConflated(const PipelineItem& item)
+{
+    if (!conflated_.empty())
+        flushConflated();
+
+    // Symbol already waits for room: newer trade replaces it, so per symbol order is kept.
+    if (auto it = conflated_.find(item.algorithm); it != conflated_.end())
+    {
+        it->second = item;
+        pipeline_->countConflated(shard_);
+        return;
+    }
+
+    if (pipeline_->push(shard_, item))
+        return;
+
+    conflated_.emplace(item.algorithm, item);
+    scheduleConflatedFlush();
+}
+
+void WebSocketClient::flushConflated()
+{
+    for (auto it = conflated_.begin(); it != conflated_.end();)
+    {
+        if (!pipeline_->push(shard_, it->second))
+            return;
+        it = conflated_.erase(it);
+    }
+}
+
+void WebSocketClient::scheduleConflatedFlush()
+{
+    // No new frames may come for a while, the timer makes sure stashed trades still reach the worker.
+    if (conflatedFlushScheduled_)
+        return;
+
+    conflatedFlushScheduled_ = true;
+    conflatedFlushTimer_.expires_after(c_conflatedFlushInterval);
+    conflatedFlushTimer_.async_wait([this, self = shared_from_this()](beast::error_code ec)
+    {
+        if (ec || stopping_ || stopped_)
+        {
+            conflatedFlushScheduled_ = false;
+            return;
+        }
+        conflatedFlushScheduled_ = false;
+        flushConflated();
+        if (!conflated_.empty())
+            scheduleConflatedFlush();
+    });
 }
 
 void WebSocketClient::fail(beast::error_code ec, const char* what)
 {
-    // Nice to add immediate reconnections attempts using some exponential backoff strategy
-    spdlog::error("WebSocket {} {}: {}. Adding this symbol {} to failedConnections list.", symbol_, what, ec.message(), symbol_);
-    WebSocketClient::failedConnections.add(symbol_); 
+    releaseAdmission(false);
+
+    // Handlers of the dropped stream complete with errors too, only the first one counts.
+    if (reconnecting_ || failed_ || stopping_ || stopped_)
+        return;
+
+    // Completions of the dropped stream that are still queued see another generation and are ignored.
+    ++generation_;
+    connected_ = false;
+    connecting_ = false;
+    urlBuilt_ = false;
+    writing_ = false;
+    controlTimer_.cancel();
+    stableTimer_.cancel();
+    connectTimer_.cancel();
+    controlMessages_.clear();
+    pendingSubscribe_.clear();
+    pendingUnsubscribe_.clear();
+    if (!disconnectedAt_)
+        disconnectedAt_ = std::chrono::steady_clock::now();
+
+    if (reconnectAttempts_ < policy_.retries)
+    {
+        spdlog::error("WebSocket {} {}: {}. Reconnect attempt {} of {}.", endpoint_, what, ec.message(), reconnectAttempts_ + 1, policy_.retries);
+        return scheduleReconnect();
+    }
+
+    spdlog::error("WebSocket {} {}: {}. Adding its {} symbols to failedConnections list.", endpoint_, what, ec.message(), algorithms_.size());
+    for (const auto& [symbol, stream] : algorithms_)
+        WebSocketClient::failedConnections.add(stream.id, ec); 
     failed_ = true;
+    // A hung handshake would otherwise keep its completion, and with it this client, alive.
+    beast::error_code ignored;
+    beast::get_lowest_layer(*ws_).close(ignored);
     return;
 }
 
-FailedConnectionsContainer WebSocketClient::failedConnections;
+void WebSocketClient::scheduleReconnect()
+{
+    reconnecting_ = true;
+    beast::error_code ignored;
+    beast::get_lowest_layer(*ws_).close(ignored);
+
+    // Capped exponential backoff with jitter in [delay/2, delay], so a mass disconnect does not reconnect in lockstep.
+    const auto exponential = policy_.baseDelay * (uint64_t{ 1 } << std::min<size_t>(reconnectAttempts_, 20));
+    const auto delay = std::min<std::chrono::milliseconds>(exponential, policy_.maxDelay);
+    const auto jittered = delay / 2 + std::chrono::milliseconds(std::uniform_int_distribution<int64_t>(0, delay.count() / 2)(random_));
+    ++reconnectAttempts_;
+
+    reconnectTimer_.expires_after(jittered);
+    reconnectTimer_.async_wait([this, self = shared_from_this()](beast::error_code ec)
+    {
+        reconnecting_ = false;
+        if (ec || stopping_)
+            return;
+
+        // Handlers of the old stream may still be queued (zero delay), generation_ keeps them away from the new one.
+        ws_.emplace(ioc_, ctx_);
+        buffer_.clear();
+        requestConnect();
+    });
+}
+
+FailedConnectionsQueue WebSocketClient::failedConnections;
 
@@ -6,13 +6,33 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl/context.hpp>
 #include <boost/asio/ssl/stream.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <spdlog/spdlog.h>
 
 #include "tradingSystem.h"
+#include "allocationCounter.h"
+#include "mpscQueue.h"
+#include "connectionScheduler.h"
 #include "securitiesManager.h"
+#include "latencyStats.h"
+#include "metrics.h"
+#include "strategyPipeline.h"
+#include "lowLatency.h"
+#include "feedCapture.h"
+#include "handlerMemory.h"
+#include "slabPool.h"
+#include "symbolTable.h"
 
 
 namespace beast = boost::beast;
@@ -20,55 +40,152 @@ namespace websocket = beast::websocket;
 namespace net = boost::asio;
 namespace ssl = boost::asio::ssl;
 
-struct FailedConnectionsContainer
+// Compact failure report, fixed size so io threads can publish it without allocating.
+struct FailureRecord
 {
-    std::unordered_set<std::string> symbols;
-    std::mutex mutex;
+    int64_t timestampNs = 0;
+    int errorCode = 0;
+    SymbolId symbolId = c_invalidSymbolId;
+};
 
-    void add(const std::string& symbol)
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-        symbols.insert(symbol);
-    }
+// Failures reported by io threads (many producers) and drained in batches by the manager (single consumer).
+// Same symbol may be reported several times, duplicates are removed by the consumer.
+struct FailedConnectionsQueue
+{
+    static constexpr size_t c_capacity = 1 << 14;
 
-    void remove(const std::string& symbol)
+    void add(SymbolId symbol, const beast::error_code& ec)
     {
-        std::lock_guard<std::mutex> lock(mutex);
-        symbols.erase(symbol);
+        FailureRecord record;
+        record.timestampNs = std::chrono::steady_clock::now().time_since_epoch().count();
+        record.errorCode = ec.value();
+        record.symbolId = symbol;
+        // When full failure is only counted: failed connection is still found by isFailed() and its symbols re-added.
+        if (!records.tryPush(record))
+            dropped.fetch_add(1, std::memory_order_relaxed);
     }
 
-    bool contains(const std::string& symbol)
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-        return symbols.count(symbol) > 0;
-    }
+    template<typename F>
+    size_t drain(F&& f) { return records.drain(std::forward<F>(f)); }
+
+    MpscQueue<FailureRecord, c_capacity> records;
+    std::atomic<uint64_t> dropped = 0;
+};
+
+// Transparent hash so per-frame lookups by std::string_view do not allocate.
+struct StringHash
+{
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
 };
 
-class WebSocketClient
+// Reconnect attempts made by WebSocketClient itself before it gives up and reports its symbols to failedConnections.
+struct ReconnectPolicy
+{
+    std::chrono::milliseconds baseDelay{ 100 };
+    std::chrono::milliseconds maxDelay{ 10000 };
+    size_t retries = 8;
+};
+
+// Per connection settings given by the manager.
+struct ClientOptions
+{
+    ReconnectPolicy reconnect;
+    ConnectionScheduler* scheduler = nullptr;
+    size_t shard = 0;
+    // Strategies run on pipeline workers when set, on the io thread otherwise.
+    StrategyPipeline* pipeline = nullptr;
+    LowLatencyProfile lowLatency;
+    // Every data frame is appended to it when set.
+    FeedCapture* capture = nullptr;
+};
+
+struct ReconnectStats
+{
+    uint64_t reconnects = 0;
+    uint64_t lastRecoveryMs = 0;
+    uint64_t maxRecoveryMs = 0;
+};
+
+// Per subscribed symbol state, owned by the io thread. Heap allocated so queued pipeline items can point to it.
+struct SymbolStream
+{
+    SymbolId id = c_invalidSymbolId;
+    std::unique_ptr<TradingAlgorithm> algorithm = std::make_unique<TradingAlgorithm>();
+    std::shared_ptr<SymbolLatency> latency;
+};
+
+// Read buffers of all clients, blocks of WebSocketClient::c_initialBufferSize reused across connection stop/start.
+SlabPool& readBufferPool();
+
+// One TLS socket to the combined "/stream?streams=" endpoint that carries many <symbol>@aggTrade streams.
+// Symbols can be added/removed on a live socket: changes are sent in-band as SUBSCRIBE/UNSUBSCRIBE messages.
+// All stream state is owned by the io thread, public methods only post work to it.
+// Held by shared_ptr: every completion handler owns a reference, so the manager may drop its own at any moment.
+// Callbacks of process wide services (DnsCache, ConnectionScheduler) lock a weak one instead and keep the client alive while they run.
+class WebSocketClient : public std::enable_shared_from_this<WebSocketClient>
 {
 public:
-    WebSocketClient(net::io_context& ioc, ssl::context& ctx, const std::string& host, const std::string& port, const std::string& symbol)
-        : ioc_(ioc)
+    // aggTrade frames are a few hundred bytes, reserve once so steady state reads never grow the buffer.
+    static constexpr size_t c_initialBufferSize = 64 * 1024;
+
+    WebSocketClient(net::io_context& ioc, ssl::context& ctx, const std::string& host, const std::string& port, const ClientOptions& options = {})
+        : scheduler_(options.scheduler)
+        , pipeline_(options.pipeline)
+        , capture_(options.capture)
+        , ioc_(ioc)
         , ctx_(ctx)
-        , resolver_(ioc_)
-        , ws_(ioc_, ctx_)
+        , ws_(std::in_place, ioc_, ctx_)
+        , controlTimer_(ioc_)
+        , reconnectTimer_(ioc_)
+        , stableTimer_(ioc_)
+        , connectTimer_(ioc_)
+        , conflatedFlushTimer_(ioc_)
+        , policy_(options.reconnect)
+        , lowLatency_(options.lowLatency)
+        , random_(std::random_device{}())
         , host_(host)
         , port_(port)
-        , symbol_(symbol)
+        , endpoint_("/stream")
+        , shard_(options.shard)
+        , metrics_(Metrics::instance().shard(options.shard))
         , stopping_(false)
     {
-        endpoint_ = "/ws/" + symbol_ + "@aggTrade";
+        buffer_.reserve(c_initialBufferSize);
+        if (lowLatency_.enabled && lowLatency_.prefaultBuffers)
+        {
+            // Fresh pages are mapped on first write, do it now instead of on first messages.
+            auto space = buffer_.prepare(c_initialBufferSize);
+            std::memset(space.data(), 0, space.size());
+        }
     }
 
+    ~WebSocketClient();
+
+    // Clients are placed into slabs reused across connection stop/start, see clientPool().
+    static void* operator new(size_t size);
+
+    // Sized, so a block goes back to where operator new took it from.
+    static void operator delete(void* pointer, size_t size);
+
+    static SlabPool& clientPool();
+
     void run(); 
     
     void stop();
 
+    void subscribe(const std::vector<SymbolId>& symbols);
+
+    void unsubscribe(const std::vector<SymbolId>& symbols);
+
     bool isStopped() { return stopped_; }
 
     bool isStopping() { return stopping_; }
 
     bool isFailed() { return failed_; }
+
+    // Safe to call from any thread.
+    ReconnectStats getReconnectStats() const { return { reconnects_, lastRecoveryMs_, maxRecoveryMs_ }; }
     
 private:
     
@@ -78,34 +195,113 @@ private:
 
     void onClose(beast::error_code ec);
 
+    void requestConnect();
+
+    void connect();
+
+    void releaseAdmission(bool connected);
+
     void onResolve(net::ip::tcp::resolver::results_type results);
     
-    void onConnect(net::ip::tcp::endpoint ep);
+    void onConnect();
     
     void onSslHandshake(); 
     
     void onHandshake(); 
+
+    // Completion of a connect step that found the client stopping.
+    void onConnectAborted();
+
+    // Retry budget is restored only once the connection stayed up for c_stableConnectionInterval.
+    void scheduleStableReset();
     
     void readMessage(); 
+
+    void onFrame(std::string_view frame, int64_t receivedNs);
+
+    // Hands the symbol's objects to the pipeline (if any) so queued items stay valid.
+    void retireStream(SymbolStream& stream);
+
+    void enqueueConflated(const PipelineItem& item);
+
+    void flushConflated();
+
+    void scheduleConflatedFlush();
+
+    void queueControlMessage(const char* method, std::vector<std::string>& streams);
+
+    void writeControlMessage();
     
     void fail(beast::error_code ec, const char* what);
+
+    void scheduleReconnect();
     
 private:
-    TradingAlgorithm algorithm_;
+    // Binance allows 5 incoming messages per second on a connection, keep control traffic under it.
+    static constexpr auto c_controlMessageInterval = std::chrono::milliseconds(250);
+    static constexpr size_t c_maxStreamsPerControlMessage = 100;
+    // Rest of the streams is subscribed after handshake, so the request line stays short.
+    static constexpr size_t c_maxStreamsInUrl = 100;
+    static constexpr uint64_t c_allocationReportInterval = 1 << 16;
+    static constexpr uint64_t c_parseErrorsLogInterval = 1024;
+    static constexpr auto c_conflatedFlushInterval = std::chrono::microseconds(200);
+    static constexpr auto c_stableConnectionInterval = std::chrono::seconds(30);
+    // Whole connect sequence: resolve, TCP connect, TLS and websocket handshakes.
+    static constexpr auto c_connectTimeout = std::chrono::seconds(10);
+
+    std::unordered_map<std::string, SymbolStream, StringHash, std::equal_to<>> algorithms_;
+    ConnectionScheduler* scheduler_ = nullptr;
+    StrategyPipeline* pipeline_ = nullptr;
+    FeedCapture* capture_ = nullptr;
     net::io_context& ioc_;
     ssl::context& ctx_;
-    net::ip::tcp::resolver resolver_;
-    websocket::stream<beast::ssl_stream<net::ip::tcp::socket>> ws_;
-    beast::flat_buffer buffer_;
+    // Recreated for every reconnect, websocket stream can not be reused after failure.
+    std::optional<websocket::stream<beast::ssl_stream<net::ip::tcp::socket>>> ws_;
+    beast::basic_flat_buffer<SlabAllocator<char, readBufferPool>> buffer_;
+    // Operation state of the read loop (async_read down to the socket read) is recycled here instead of the heap.
+    HandlerMemory readHandlerMemory_;
+    AllocationsPerMessage allocations_;
+    net::steady_timer controlTimer_;
+    net::steady_timer reconnectTimer_;
+    net::steady_timer stableTimer_;
+    net::steady_timer connectTimer_;
+    // Latest trade per symbol that did not fit into the full pipeline ring (conflate policy), flushed before newer ones.
+    std::unordered_map<TradingAlgorithm*, PipelineItem> conflated_;
+    net::steady_timer conflatedFlushTimer_;
+    bool conflatedFlushScheduled_ = false;
+    ReconnectPolicy policy_;
+    LowLatencyProfile lowLatency_;
+    std::minstd_rand random_;
+    std::optional<std::chrono::steady_clock::time_point> disconnectedAt_;
+    std::vector<std::string> pendingSubscribe_;
+    std::vector<std::string> pendingUnsubscribe_;
+    std::deque<std::string> controlMessages_;
     std::string host_;
     std::string port_;
-    std::string symbol_;
     std::string endpoint_;
-    bool stopping_ = false;
-    bool stopped_ = false;
-    bool failed_ = false;
+    size_t shard_ = 0;
+    // Counters of this client's io thread, shared with other clients of the shard.
+    ShardMetrics& metrics_;
+    size_t controlMessageId_ = 0;
+    uint64_t parseErrors_ = 0;
+    size_t reconnectAttempts_ = 0;
+    // Bumped whenever the stream is dropped, handlers started on an older stream compare it and return.
+    uint64_t generation_ = 0;
+    bool reconnecting_ = false;
+    bool admitted_ = false;
+    // TCP connect, TLS or websocket handshake is in flight on ws_.
+    bool connecting_ = false;
+    // Streams of algorithms_ are in the handshake URL or pending SUBSCRIBE, set from onSslHandshake until the stream is dropped.
+    bool urlBuilt_ = false;
+    bool connected_ = false;
+    bool writing_ = false;
+    std::atomic<bool> stopping_ = false;
+    std::atomic<bool> stopped_ = false;
+    std::atomic<bool> failed_ = false;
+    std::atomic<uint64_t> reconnects_ = 0;
+    std::atomic<uint64_t> lastRecoveryMs_ = 0;
+    std::atomic<uint64_t> maxRecoveryMs_ = 0;
 public:
-    static FailedConnectionsContainer failedConnections;
+    static FailedConnectionsQueue failedConnections;
 };
 
-
@@ -10,6 +10,7 @@
 #include <boost/beast/websocket.hpp>
 #include <boost/asio/thread_pool.hpp>
 #include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
 
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
@@ -30,6 +31,8 @@
 
 #include "parser.h"
 #include "securitiesManager.h"
+#include "tlsSessionCache.h"
+#include "latencyStats.h"
 
 WebSocketsManager::WebSocketsManager() 
 {
@@ -42,10 +45,27 @@ WebSocketsManager::WebSocketsManager()
     {
         spdlog::info("Problem during SSL sertificate load. Ensure you have cacert.pem for ssl handshake");
     }
+    TlsSessionCache::instance().attach(ctx);
     checkConnectionsLimit();
 }
 
-void WebSocketsManager::update(const std::vector<std::string>& symbols)
+WebSocketsManager::~WebSocketsManager()
+{
+    if(_ioPool)
+        _ioPool->stop();
+    // Pending handlers own their clients: drop our references and then the io_contexts with those handlers,
+    // while pipeline and capture the clients retire their streams into are still alive.
+    _bufferForClosedConnections.clear();
+    _clients.clear();
+    _latencyDumpTimer.reset();
+    _latencyDumpSignal.reset();
+    _scheduler.reset();
+    _ioPool.reset();
+    if(_pipeline)
+        _pipeline->stop();
+}
+
+void WebSocketsManager::update(const std::vector<SymbolId>& symbols)
 {
     if(!_connectionsEstablished.isDone())
         establishConnections(symbols);
@@ -53,103 +73,353 @@ void WebSocketsManager::update(const std::vector<std::string>& symbols)
         updateConnections(symbols);
 }
 
-void WebSocketsManager::establishConnections(const std::vector<std::string>& symbols)
+void WebSocketsManager::establishConnections(const std::vector<SymbolId>& symbols)
 {
-    // new thread because it will call ioc.run() and block thread
-    std::thread([this, &symbols](){ 
-        establishConnectionsInternal(symbols);
-    }).detach();
+    // io threads block in ioc.run(), connections are only created from here
+    if(!_ioPool)
+    {
+        _lowLatency.applyToProcess();
+        _ioPool = std::make_unique<IoContextPool>(_ioThreads, _pinIoThreads || _lowLatency.enabled, _lowLatency.enabled && _lowLatency.busyPollLoop);
+        _fillingConnection.assign(_ioPool->size(), nullptr);
+        _scheduler = std::make_unique<ConnectionScheduler>(_ioPool->get(0), _maxInFlightHandshakes, _connectsPerSecond);
+        if(_pipelineWorkers > 0)
+        {
+            _pipeline = std::make_unique<StrategyPipeline>(_ioPool->size(), _pipelineWorkers, _pipelineCapacity, _pipelinePolicy, _pipelineBlockTimeout);
+            _pipeline->run();
+        }
+        if(!_captureFile.empty())
+        {
+            try
+            {
+                _capture = std::make_unique<FeedCapture>(_captureFile, _ioPool->size());
+            }
+            catch(const std::exception& e)
+            {
+                spdlog::error("Capture disabled: {}", e.what());
+            }
+        }
+        _latencyDumpTimer = std::make_unique<boost::asio::steady_timer>(_ioPool->get(0));
+        _latencyDumpSignal = std::make_unique<boost::asio::signal_set>(_ioPool->get(0), SIGUSR1);
+        scheduleLatencyDump();
+        waitForLatencyDumpSignal();
+        _ioPool->run();
+    }
+    establishConnectionsInternal(symbols);
 }
 
-void WebSocketsManager::establishConnectionsInternal(const std::vector<std::string>& symbols)
+void WebSocketsManager::establishConnectionsInternal(const std::vector<SymbolId>& symbols)
 {
     if(symbols.empty())
         return;
 
     {
         std::lock_guard<std::mutex> lock(_clientsMutex);
-        for (size_t i = 0; i < symbols.size(); ++i)
+        _wantedSymbols.assign(symbols);
+        for (SymbolId symbol : symbols)
         {
-            if(i >= _connectionsLimit)
+            addClient(symbol, ctx);
+            if(!containsSymbol(symbol))
             {
                 spdlog::info("WARNING: Exceed connections limit (ulimit)");
                 break;
             }
-
-            addClient(symbols[i], ctx);
         }
+        spdlog::info("{} symbols multiplexed over {} connections on {} io threads", _subscribedSymbols, _clients.size(), _ioPool->size());
     }
 
     _connectionsEstablished.endEvent(); // remember that we have established connections.
-    ioc.run();
 }
 
-void WebSocketsManager::updateConnections(const std::vector<std::string>& symbols)
+void WebSocketsManager::updateConnections(const std::vector<SymbolId>& symbols)
 {
     spdlog::info("Update connections");
 
     std::lock_guard<std::mutex> lock(_clientsMutex);
-    removeUnnecessaryConnections(symbols);
-    for(const auto& i : symbols)
+    drainFailedConnections();
+
+    SymbolSet wanted(symbols);
+    const SymbolDiff diff = SymbolSet::diff(_wantedSymbols, wanted);
+    _wantedSymbols = std::move(wanted);
+    if(!diff.added.empty() || !diff.removed.empty())
+        spdlog::info("Symbols since last update: {} added, {} removed", diff.added.size(), diff.removed.size());
+
+    removeUnnecessaryConnections(diff.removed);
+    if(_pipeline)
+        _pipeline->reclaim();
+    addMissingSymbols(symbols);
+}
+
+void WebSocketsManager::reconnectFailed()
+{
+    if(!_connectionsEstablished.isDone())
+        return;
+
+    std::lock_guard<std::mutex> lock(_clientsMutex);
+    drainFailedConnections();
+    removeUnnecessaryConnections({});
+    if(_pipeline)
+        _pipeline->reclaim();
+    addMissingSymbols(_wantedSymbols.ids());
+}
+
+void WebSocketsManager::addMissingSymbols(const std::vector<SymbolId>& symbols)
+{
+    for(SymbolId i : symbols)
     {
-        if(!isAbleToAddNewConnections())
+        if(containsSymbol(i))
+            continue;
+
+        addClient(i, ctx);
+        if(!containsSymbol(i))
         {
             spdlog::info("WARNING: Exceed connections limit (ulimit), zero new clients will be added");
             break;
         }
-        WebSocketClient::failedConnections.remove(i);
-        addClient(i, ctx);
     }
 }
 
-void WebSocketsManager::addClient(const std::string& symbol, boost::asio::ssl::context& ctx) 
+void WebSocketsManager::drainFailedConnections()
 {
-    if(_clients.find(symbol) == _clients.end())
+    // Reports are only counted: failed connections are found by isFailed() and every wanted symbol without a connection is re-added,
+    // which also covers reports dropped on a full queue.
+    const size_t reports = WebSocketClient::failedConnections.drain([](const FailureRecord&) {});
+
+    const uint64_t dropped = WebSocketClient::failedConnections.dropped.exchange(0, std::memory_order_relaxed);
+    if(reports > 0 || dropped > 0)
+        spdlog::info("{} failure reports ({} dropped) since last update, their symbols will be reconnected", reports, dropped);
+}
+
+void WebSocketsManager::addClient(SymbolId symbol, boost::asio::ssl::context& ctx) 
+{
+    if(containsSymbol(symbol))
+        return;
+
+    // Symbol always goes to the same shard. Fill the shard's newest live connection first, open another socket only when it is full.
+    const std::string& name = SymbolTable::instance().name(symbol);
+    const size_t shard = _ioPool->shardOf(name);
+    Connection* connection = _fillingConnection[shard];
+    if(connection && (connection->symbols.size() >= _streamsPerConnection || connection->client->isFailed() || connection->client->isStopping()))
+        connection = nullptr;
+
+    if(!connection)
     {
-        spdlog::info("Adding symbol: {}", symbol);
-        static size_t indexInc = 0; // make it something else
-        _clients[symbol] = std::make_unique<WebSocketClient>(ioc, ctx, "stream.binance.com", "443", symbol);
-        _clients[symbol]->run();
+        if(!isAbleToAddNewConnections())
+            return;
+
+        _clients.push_back(std::make_unique<Connection>());
+        connection = _clients.back().get();
+        connection->shard = shard;
+        // Not make_shared: the client must come from its own operator new (slab pool).
+        connection->client.reset(new WebSocketClient(_ioPool->get(shard), ctx, _streamHost, _streamPort,
+            ClientOptions{ _reconnectPolicy, _scheduler.get(), shard, _pipeline.get(), _lowLatency, _capture.get() }));
+        connection->client->run();
+        _fillingConnection[shard] = connection;
     }
+
+    spdlog::info("Adding symbol: {}", name);
+    connection->symbols.push_back(symbol);
+    _symbolToConnection[symbol] = connection;
+    ++_subscribedSymbols;
+    connection->client->subscribe({symbol});
 }
 
-void WebSocketsManager::removeUnnecessaryConnections(const std::vector<std::string>& symbols)
+void WebSocketsManager::removeUnnecessaryConnections(const std::vector<SymbolId>& removed)
 {
-    // Remove connections that are not satisfy current filtration or failed
-    std::vector<std::string> clientsToRemove;
-    for(const auto& [k,v] : _clients)
+    _removedSymbols.assign(removed);
+
+    // Failed or emptied connections are stopped, the rest get UNSUBSCRIBE for symbols that no longer satisfy current filtration.
+    // Every subscribed symbol is looked at once with a flat membership check, so this is linear in number of symbols.
+    for(auto it = _clients.begin(); it != _clients.end();)
     {
-        if(std::find(symbols.begin(), symbols.end(), k) == symbols.end() || (v && v->isFailed())) 
+        Connection& connection = **it;
+        if(!connection.client->isFailed())
         {
-            if(stopClient(k))
-                clientsToRemove.push_back(k);
+            std::vector<SymbolId> toUnsubscribe;
+            std::erase_if(connection.symbols, [this, &toUnsubscribe](SymbolId symbol)
+            {
+                if(!_removedSymbols.contains(symbol))
+                    return false;
+                toUnsubscribe.push_back(symbol);
+                _symbolToConnection.reset(symbol);
+                --_subscribedSymbols;
+                spdlog::info("Unsubscribed symbol: {}", SymbolTable::instance().name(symbol));
+                return true;
+            });
+
+            if(!toUnsubscribe.empty() && !connection.symbols.empty())
+                connection.client->unsubscribe(toUnsubscribe);
+
+            if(!connection.symbols.empty())
+            {
+                ++it;
+                continue;
+            }
         }
+
+        // Symbols of a failed connection are added again to some other connection by updateConnections
+        retireConnection(connection);
+        it = _clients.erase(it);
     }
 
-    for(const auto& k : clientsToRemove)
+    std::erase_if(_bufferForClosedConnections, [this](auto& client){ return stopClient(*client); });
+}
+
+void WebSocketsManager::logReconnectStats()
+{
+    spdlog::info("TLS handshakes: {} resumed, {} full", TlsSessionCache::instance().resumedHandshakes(), TlsSessionCache::instance().fullHandshakes());
+
+    std::lock_guard<std::mutex> lock(_clientsMutex);
+    for(const auto& connection : _clients)
     {
-        _clients.erase(k);
-        spdlog::info("Removed WebSocketClient for symbol: {}", k);
+        const ReconnectStats stats = connection->client->getReconnectStats();
+        if(stats.reconnects == 0)
+            continue;
+
+        for(SymbolId symbol : connection->symbols)
+            spdlog::info("Symbol {}: {} reconnects, last recovery {} ms, max recovery {} ms", SymbolTable::instance().name(symbol), stats.reconnects, stats.lastRecoveryMs, stats.maxRecoveryMs);
     }
 }
 
-bool WebSocketsManager::stopClient(const std::string& symbol) 
+void WebSocketsManager::scheduleLatencyDump()
 {
-    auto it = _clients.find(symbol);
-    if (it != _clients.end() && it->second)
+    if(_latencyDumpInterval.count() == 0)
+        return;
+
+    _latencyDumpTimer->expires_after(_latencyDumpInterval);
+    _latencyDumpTimer->async_wait([this](const boost::system::error_code& ec)
     {
-        if(!it->second->isStopped() && !it->second->isStopping())
-        {
-            it->second->stop(); 
-            spdlog::info("Stopping WebSocketClient for symbol: {}", symbol);
-            return false;
-        }
-        else if(it->second->isStopped())
+        if(ec)
+            return;
+        requestLatencyDump();
+        scheduleLatencyDump();
+    });
+}
+
+void WebSocketsManager::waitForLatencyDumpSignal()
+{
+    _latencyDumpSignal->async_wait([this](const boost::system::error_code& ec, int)
+    {
+        if(ec)
+            return;
+        requestLatencyDump();
+        waitForLatencyDumpSignal();
+    });
+}
+
+void WebSocketsManager::requestLatencyDump()
+{
+    // Merging histograms of every symbol and writing the file would stall all connections of shard 0.
+    _latencyDumpDue = true;
+    if(_latencyDumpWake)
+        _latencyDumpWake();
+}
+
+void WebSocketsManager::dumpLatencyIfDue()
+{
+    if(!_latencyDumpDue.exchange(false))
+        return;
+
+    LatencyRegistry::instance().logSummary();
+    std::ofstream file(_latencyDumpFile, std::ios::trunc);
+    if(!file)
+    {
+        spdlog::error("Failed to open latency dump file {}", _latencyDumpFile);
+        return;
+    }
+    LatencyRegistry::instance().dump(file);
+    spdlog::info("Latency per symbol written to {}", _latencyDumpFile);
+}
+
+void WebSocketsManager::writeMetrics(MetricsText& text)
+{
+    size_t live = 0;
+    size_t failed = 0;
+    size_t stopping = 0;
+    size_t symbols = 0;
+    size_t closing = 0;
+    size_t limit = 0;
+    {
+        std::lock_guard<std::mutex> lock(_clientsMutex);
+        for(const auto& connection : _clients)
         {
-            return true;
+            if(connection->client->isFailed())
+                ++failed;
+            else if(connection->client->isStopping())
+                ++stopping;
+            else
+                ++live;
         }
+        symbols = _subscribedSymbols;
+        closing = _bufferForClosedConnections.size();
+        limit = _connectionsLimit;
+    }
+
+    text.family("scrapper_connections", "gauge", "Websocket connections by state.");
+    text.sample("scrapper_connections", live, "state=\"live\"");
+    text.sample("scrapper_connections", failed, "state=\"failed\"");
+    text.sample("scrapper_connections", stopping, "state=\"stopping\"");
+    text.sample("scrapper_connections", closing, "state=\"closing\"");
+    text.family("scrapper_subscribed_symbols", "gauge", "Symbols assigned to connections.");
+    text.sample("scrapper_subscribed_symbols", symbols);
+    text.family("scrapper_connections_limit", "gauge", "Connections allowed by descriptors limit (ulimit -n).");
+    text.sample("scrapper_connections_limit", limit);
+    text.family("scrapper_connections_limit_usage_ratio", "gauge", "Used part of connections limit, closing connections included.");
+    text.sample("scrapper_connections_limit_usage_ratio", limit ? static_cast<double>(live + failed + stopping + closing) / limit : 0.0);
+
+    text.family("scrapper_client_pool_blocks", "gauge", "Slab blocks for websocket clients and their read buffers, reused across connection stop/start.");
+    text.sample("scrapper_client_pool_blocks", WebSocketClient::clientPool().blocksInUse(), "pool=\"clients\",state=\"used\"");
+    text.sample("scrapper_client_pool_blocks", WebSocketClient::clientPool().blocksAllocated(), "pool=\"clients\",state=\"allocated\"");
+    text.sample("scrapper_client_pool_blocks", readBufferPool().blocksInUse(), "pool=\"read_buffers\",state=\"used\"");
+    text.sample("scrapper_client_pool_blocks", readBufferPool().blocksAllocated(), "pool=\"read_buffers\",state=\"allocated\"");
+
+    // Scheduler, pipeline and capture are created once before the first connection and never replaced.
+    if(_scheduler)
+    {
+        text.family("scrapper_connect_attempts", "gauge", "Connection attempts (resolve, connect, TLS and websocket handshakes) by scheduler state.");
+        text.sample("scrapper_connect_attempts", _scheduler->inFlight(), "state=\"in_flight\"");
+        text.sample("scrapper_connect_attempts", _scheduler->queued(), "state=\"queued\"");
+        text.family("scrapper_time_to_all_connected_seconds", "gauge", "Duration of the last connection ramp, from first attempt after idle until none was queued nor in flight.");
+        text.sample("scrapper_time_to_all_connected_seconds", std::chrono::duration<double>(_scheduler->lastTimeToAllConnected()).count());
+    }
+    if(_pipeline)
+        _pipeline->writeMetrics(text);
+    if(_capture)
+    {
+        text.family("scrapper_capture_dropped_total", "counter", "Frames not captured because the writer could not keep up.");
+        text.sample("scrapper_capture_dropped_total", static_cast<double>(_capture->droppedFrames()));
+    }
+}
+
+void WebSocketsManager::releaseSymbols(Connection& connection)
+{
+    for(SymbolId symbol : connection.symbols)
+        _symbolToConnection.reset(symbol);
+    _subscribedSymbols -= connection.symbols.size();
+    connection.symbols.clear();
+}
+
+void WebSocketsManager::retireConnection(Connection& connection)
+{
+    releaseSymbols(connection);
+    if(_fillingConnection[connection.shard] == &connection)
+        _fillingConnection[connection.shard] = nullptr;
+    stopClient(*connection.client);
+    _bufferForClosedConnections.push_back(std::move(connection.client));
+}
+
+bool WebSocketsManager::stopClient(WebSocketClient& client) 
+{
+    if(!client.isStopped() && !client.isStopping())
+    {
+        client.stop(); 
+        spdlog::info("Stopping WebSocketClient");
+        return false;
+    }
+    else if(client.isStopped())
+    {
+        spdlog::info("Removed WebSocketClient");
+        return true;
     }
-    spdlog::info("WebSocketClient not found for symbol: {}", symbol);
     return false;
 }
 
@@ -194,13 +464,11 @@ void WebSocketsManager::checkConnectionsLimit()
 void WebSocketsManager::stopSomeConnectionsAndDecreaseConnectionsLimit(size_t num)
 {
     std::lock_guard<std::mutex> lock(_clientsMutex);
-    for(const auto& [k,v] : _clients)
+    while(num-- > 0 && !_clients.empty())
     {
-        if(num-- > 0)
-        {
-            spdlog::info("Remove client number {}", num+1);
-            stopClient(k);
-            _connectionsLimit--;
-        }
+        spdlog::info("Remove client number {}", num+1);
+        retireConnection(*_clients.back());
+        _clients.pop_back();
+        _connectionsLimit--;
     }
 }
@@ -1,44 +1,153 @@
 #pragma once
 #include "webSocketConnection.h"
+#include "ioContextPool.h"
 #include "Event.h"
+#include "metrics.h"
 
 class WebSocketsManager 
 {
 public:
     WebSocketsManager();
 
-    void update(const std::vector<std::string>& symbols);
+    // Joins io threads (and strategy workers) first: their handlers capture this and the clients.
+    ~WebSocketsManager();
+
+    void update(const std::vector<SymbolId>& symbols);
+
+    // Periodic work when the list of symbols did not change: failed connections are replaced, nothing else is touched.
+    void reconnectFailed();
 
     void stopSomeConnectionsAndDecreaseConnectionsLimit(size_t num);
+
+    void setStreamsPerConnection(size_t num) { _streamsPerConnection = std::max<size_t>(num, 1); }
+
+    void setReconnectPolicy(const ReconnectPolicy& policy) { _reconnectPolicy = policy; }
+
+    // Takes effect only before the first update().
+    void setConnectionRamp(size_t maxInFlightHandshakes, double connectsPerSecond) { _maxInFlightHandshakes = maxInFlightHandshakes; _connectsPerSecond = connectsPerSecond; }
+
+    // Takes effect only before the first update(). Zero interval dumps only on SIGUSR1.
+    // Timer and signal only mark the dump as due and call wake, the caller then runs dumpLatencyIfDue() on its own thread.
+    void setLatencyDump(std::chrono::seconds interval, const std::string& file, std::function<void()> wake)
+    {
+        _latencyDumpInterval = interval;
+        _latencyDumpFile = file;
+        _latencyDumpWake = std::move(wake);
+    }
+
+    // Merges latency histograms and writes the dump file if it is due. Heavy, never called on io threads.
+    void dumpLatencyIfDue();
+
+    // Reconnects done by connections themselves and time it took them to recover, per symbol.
+    void logReconnectStats();
+
+    // Takes effect only before the first update(). Zero workers keeps strategies on io threads.
+    void setPipeline(size_t workers, size_t capacity, OverflowPolicy policy, std::chrono::microseconds blockTimeout) { _pipelineWorkers = workers; _pipelineCapacity = capacity; _pipelinePolicy = policy; _pipelineBlockTimeout = blockTimeout; }
+
+    // Takes effect only before the first update(). Enabled profile also pins io threads.
+    void setLowLatencyProfile(const LowLatencyProfile& profile) { _lowLatency = profile; }
+
+    // Takes effect only before the first update(). Empty path - no capture.
+    void setCaptureFile(const std::string& path) { _captureFile = path; }
+
+    // Used for connections created from now on.
+    void setStreamEndpoint(const std::string& host, const std::string& port) { _streamHost = host; _streamPort = port; }
+
+    // Call before the first update(), context is shared with running connections afterwards.
+    void addTrustedCertificates(const std::string& file) { ctx.load_verify_file(file); }
+
+    // Connection gauges for metrics scrape, called from the metrics thread.
+    void writeMetrics(MetricsText& text);
+
+    // Takes effect only before the first update(), connections never migrate between io threads.
+    void setIoThreads(size_t num, bool pinThreads) { _ioThreads = num; _pinIoThreads = pinThreads; }
 private:
-    void establishConnections(const std::vector<std::string>& symbols);
+    // Manager side view of one multiplexed socket, only touched under _clientsMutex.
+    struct Connection
+    {
+        std::shared_ptr<WebSocketClient> client;
+        std::vector<SymbolId> symbols;
+        size_t shard = 0;
+    };
 
-    void establishConnectionsInternal(const std::vector<std::string>& symbols);
+    void establishConnections(const std::vector<SymbolId>& symbols);
 
-    void updateConnections(const std::vector<std::string>& symbols);
+    void establishConnectionsInternal(const std::vector<SymbolId>& symbols);
 
-    void addClient(const std::string& symbol, boost::asio::ssl::context& ctx); 
+    void updateConnections(const std::vector<SymbolId>& symbols);
+
+    // Subscribes wanted symbols that have no connection: new ones, those of retired failed connections and those that did not fit under the limit before.
+    void addMissingSymbols(const std::vector<SymbolId>& symbols);
+
+    void addClient(SymbolId symbol, boost::asio::ssl::context& ctx); 
     
-    bool stopClient(const std::string& symbol);
+    bool stopClient(WebSocketClient& client);
 
-    bool containsSymbol(const std::string& symbol) const { return _clients.find(symbol) != _clients.end(); }
+    bool containsSymbol(SymbolId symbol) const { return _symbolToConnection.get(symbol) != nullptr; }
 
     size_t getNumOfClients() const { return _clients.size(); }
 
-    void removeUnnecessaryConnections(const std::vector<std::string>& symbols);
+    void releaseSymbols(Connection& connection);
+
+    void drainFailedConnections();
+
+    void retireConnection(Connection& connection);
+
+    // Unsubscribes removed symbols and retires failed or emptied connections.
+    void removeUnnecessaryConnections(const std::vector<SymbolId>& removed);
 
     void checkConnectionsLimit();
 
+    void scheduleLatencyDump();
+
+    void waitForLatencyDumpSignal();
+
+    void requestLatencyDump();
+
     size_t getConnectionsLimit() const { return _connectionsLimit; }
 
-    bool isAbleToAddNewConnections()const { return _clients.size() < _connectionsLimit; }
+    bool isAbleToAddNewConnections()const { return _clients.size() + _bufferForClosedConnections.size() < _connectionsLimit; }
 
 private:
     std::mutex _clientsMutex;
     size_t _connectionsLimit = 0;
-    std::unordered_map<std::string, std::unique_ptr<WebSocketClient>> _clients;
-    std::vector<std::unique_ptr<WebSocketClient>> _bufferForClosedConnections;
-    boost::asio::io_context ioc;
+    size_t _ioThreads = 1;
+    bool _pinIoThreads = false;
+    size_t _maxInFlightHandshakes = 8;
+    double _connectsPerSecond = 5.0;
+    // Declared before clients: sockets must be destroyed before their io_context.
+    std::unique_ptr<IoContextPool> _ioPool;
+    std::unique_ptr<ConnectionScheduler> _scheduler;
+    // Declared before clients: retired per symbol objects are freed with it.
+    std::unique_ptr<StrategyPipeline> _pipeline;
+    size_t _pipelineWorkers = 0;
+    size_t _pipelineCapacity = 4096;
+    OverflowPolicy _pipelinePolicy = OverflowPolicy::Block;
+    std::chrono::microseconds _pipelineBlockTimeout{ 0 };
+    LowLatencyProfile _lowLatency;
+    std::unique_ptr<FeedCapture> _capture;
+    std::string _captureFile;
+    std::string _streamHost = "stream.binance.com";
+    std::string _streamPort = "443";
+    // Both live on io thread of shard 0, they only set _latencyDumpDue.
+    std::unique_ptr<boost::asio::steady_timer> _latencyDumpTimer;
+    std::unique_ptr<boost::asio::signal_set> _latencyDumpSignal;
+    std::chrono::seconds _latencyDumpInterval{ 60 };
+    std::string _latencyDumpFile = "latency.txt";
+    std::function<void()> _latencyDumpWake;
+    std::atomic<bool> _latencyDumpDue = false;
+    // Binance caps a single connection at 1024 streams.
+    size_t _streamsPerConnection = 1000;
+    ReconnectPolicy _reconnectPolicy;
+    std::vector<std::unique_ptr<Connection>> _clients;
+    SymbolMap<Connection*> _symbolToConnection{ nullptr };
+    size_t _subscribedSymbols = 0;
+    // Symbols wanted by the last update, next update is reconciled against it.
+    SymbolSet _wantedSymbols;
+    SymbolSet _removedSymbols;
+    // Connection that new symbols of a shard are added to until it is full.
+    std::vector<Connection*> _fillingConnection;
+    std::vector<std::shared_ptr<WebSocketClient>> _bufferForClosedConnections;
     boost::asio::ssl::context ctx{ boost::asio::ssl::context::tlsv12_client };
     Event _connectionsEstablished;
 };